@@ -0,0 +1,147 @@
+/**************************************************************************//**
+* @file
+*     モジュール名：共通メモリ管理機能 性能測定共通処理
+* <pre>
+*
+*    １  機能
+*          複数プロセスで同じ処理を一定時間繰り返し、全プロセスの合計
+*          処理回数からスループットを求める性能測定の共通処理を定義する。
+*          共有メモリは事前にシステムモニタ(Access::init(設定ファイル,
+*          データパス))で作成しておくこと
+*
+*    ２  更新履歴
+*          REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+#ifndef SHAREDMEMORY_BENCHUTIL_H_
+#define SHAREDMEMORY_BENCHUTIL_H_
+
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <vector>
+
+namespace SharedMemory
+{
+namespace Bench
+{
+/**************************************************************************//**
+*   関数名 : 現在時刻取得(usecNow)
+*   引数   : なし
+*   戻り値 : 単調増加時刻(μs)
+**//**************************************************************************/
+inline uint64_t usecNow() {
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000uL
+            + static_cast<uint64_t>(ts.tv_nsec) / 1000uL;
+}
+
+/**************************************************************************//**
+* クラス名 : 処理回数除外(Skip)
+*            測定処理から送出すると、その回は処理回数に含めない
+**//**************************************************************************/
+class Skip { };
+
+/**************************************************************************//**
+*   関数名 : 複数プロセス実行(runProcesses)
+*            procs個の子プロセスを起動し、各プロセスでsetupを実行した後、
+*            全プロセスの準備完了を待って同時にbodyをmsecの間繰り返す。
+*            各プロセスの処理回数をパイプで集計する
+*   引数   : procs : プロセス数                              [入力]
+*            msec  : 測定時間(ms)                            [入力]
+*            setup : 準備処理(引数はプロセス番号)            [入力]
+*            body  : 測定処理(引数はプロセス番号・回数)      [入力]
+*   戻り値 : 全プロセスの合計処理回数
+**//**************************************************************************/
+template<typename Setup, typename Body>
+uint64_t runProcesses(size_t procs, uint64_t msec, Setup setup, Body body) {
+    int ready[2], start[2], result[2];
+    if(::pipe(ready) != 0 || ::pipe(start) != 0 || ::pipe(result) != 0) {
+        ::perror("pipe");
+        ::exit(1);
+    }
+
+    ::std::vector<pid_t> children;
+    for(size_t proc = 0; proc < procs; proc++) {
+        const pid_t pid = ::fork();
+        if(pid < 0) {
+            ::perror("fork");
+            ::exit(1);
+        }
+        if(pid != 0) {
+            children.push_back(pid);
+            continue;
+        }
+        // 子プロセス
+        ::close(ready[0]);
+        ::close(start[1]);
+        ::close(result[0]);
+        uint64_t count = 0;
+        int status = 0;
+        try {
+            setup(proc);
+            char c = 0;
+            if(::write(ready[1], &c, 1) != 1) ::_exit(1);
+            ::close(ready[1]);
+            // 親プロセスが開始パイプを閉じるまで待つ
+            while(::read(start[0], &c, 1) > 0) { }
+            const uint64_t end = usecNow() + msec * 1000uL;
+            while(usecNow() < end) {
+                for(int i = 0; i < 64; i++) {
+                    try {
+                        body(proc, count);
+                        count++;
+                    } catch(const Skip&) { }
+                }
+            }
+        } catch(const ::std::exception& e) {
+            ::fprintf(stderr, "proc %zu : %s\n", proc, e.what());
+            count = 0;
+            status = 1;
+        } catch(...) {
+            ::fprintf(stderr, "proc %zu : 例外が発生しました\n", proc);
+            count = 0;
+            status = 1;
+        }
+        if(::write(result[1], &count, sizeof(count)) != sizeof(count)) status = 1;
+        ::_exit(status);
+    }
+
+    // 全プロセスの準備完了を待って開始する
+    // (準備に失敗したプロセスは終了し、パイプが閉じられる)
+    ::close(ready[1]);
+    ::close(start[0]);
+    ::close(result[1]);
+    for(size_t i = 0; i < procs; i++) {
+        char c;
+        if(::read(ready[0], &c, 1) != 1) break;
+    }
+    ::close(start[1]);
+
+    uint64_t total = 0;
+    for(size_t i = 0; i < procs; i++) {
+        uint64_t count = 0;
+        if(::read(result[0], &count, sizeof(count)) == sizeof(count)) total += count;
+    }
+    for(auto it = children.begin(); it != children.end(); it++) {
+        int status = 0;
+        ::waitpid(*it, &status, 0);
+        if(!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            ::fprintf(stderr, "pid %d : 異常終了しました\n", *it);
+    }
+    ::close(ready[0]);
+    ::close(result[0]);
+    return total;
+}
+
+/*--------1---------2---------3---------4---------5---------6---------7------*/
+}  // end namespace Bench
+}  // end namespace SharedMemory
+
+#endif /* SHAREDMEMORY_BENCHUTIL_H_ */
@@ -0,0 +1,96 @@
+/**************************************************************************//**
+* @file
+*     モジュール名：共通メモリ管理機能 テーブル別書込み性能測定
+* <pre>
+*
+*    １  機能
+*          複数プロセスから挿入・コミットを繰り返し、書込みのスループットを
+*          書込み先のテーブル数毎に測定する。プロセスは書込み先のテーブルを
+*          順に割り当てるため、テーブル数を増やすとインデックス管理情報の
+*          更新ロックが分散する。
+*          各テーブルの先頭要素を複製して挿入するため、先頭要素を登録し、
+*          キー重複とならないインデックスを定義しておくこと。
+*          キー重複・タイムアウト・競合となった挿入はロールバックし、
+*          件数に含めない
+*
+*          使用方法：IndexRootBench データパス エンティティ名[,エンティティ名...]
+*                    [最大プロセス数 [測定時間(秒)]]
+*          テーブル数は1から指定数まで、プロセス数は1から最大プロセス数まで
+*          倍にしながら測定する
+*
+*    ２  更新履歴
+*          REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+#include <Bench/BenchUtil.h>
+#include <Init/Initializer.h>
+#include <Main/Access.h>
+#include <Main/Connection.h>
+#include <Manager/Entity.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "inc/SHMConst.h"
+
+using namespace SharedMemory;
+
+int main(int argc, char* argv[]) {
+    if(argc < 3) {
+        ::fprintf(stderr, "usage: %s dataPath entity[,entity...] [procs [sec]]\n", argv[0]);
+        return 1;
+    }
+    const ::std::string dataPath = argv[1];
+    ::std::vector<::std::string> entities;
+    ::std::stringstream names(argv[2]);
+    for(::std::string name; ::std::getline(names, name, ',');)
+        if(!name.empty()) entities.push_back(name);
+    const size_t maxProcs = argc > 3 ? ::strtoul(argv[3], nullptr, 10) : 64;
+    const uint64_t msec = (argc > 4 ? ::strtoul(argv[4], nullptr, 10) : 3) * 1000uL;
+
+    for(size_t tables = 1; tables <= entities.size(); tables *= 2) {
+        for(size_t procs = 1; procs <= maxProcs; procs *= 2) {
+            ::std::vector<char> buf;
+            ::std::unique_ptr<::Entity::AppTable> data;
+            const uint64_t total = Bench::runProcesses(procs, msec,
+                [&](size_t proc) {
+                    Access::init(dataPath);
+                    const ::std::string& entity = entities[proc % tables];
+                    auto it = Initializer::table_map.find(entity);
+                    if(it == Initializer::table_map.end() || it->second == nullptr
+                            || it->second->used_end == 0) {
+                        ::fprintf(stderr, "エンティティ(先頭要素)がありません:%s\n",
+                                entity.c_str());
+                        ::_exit(1);
+                    }
+                    // 先頭要素を挿入データとして複製する
+                    SharedMemory::Entity& tbl = *it->second;
+                    buf.resize(tbl.tuple_size);
+                    ::memcpy(buf.data(), &tbl.getTuple(0), tbl.tuple_size);
+                    data.reset(new ::Entity::AppTable(entity,
+                            *reinterpret_cast<::Entity::AbstEntity*>(buf.data())));
+                },
+                [&](size_t, uint64_t) {
+                    Connection& cnn = Access::getConnection();
+                    try {
+                        if(cnn.executeInsert(*data) == EXECUTE_OK) {
+                            cnn.commitTransaction();
+                            return;
+                        }
+                    } catch(::Exception::timeout& e) {
+                    } catch(::Exception::lock_failed& e) {
+                    }
+                    cnn.rollbackTransaction();
+                    throw Bench::Skip();
+                });
+            ::printf("tables=%zu procs=%zu commits=%lu commits/s=%.0f\n", tables, procs,
+                    total, static_cast<double>(total) * 1000.0 / static_cast<double>(msec));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,69 @@
+/**************************************************************************//**
+* @file
+*     モジュール名：共通メモリ管理機能 ロック性能測定
+* <pre>
+*
+*    １  機能
+*          複数プロセスから同じエンティティのロック取得・開放を繰り返し、
+*          スループットを測定する。PTHREAD_MUTEXを定義してビルドすると
+*          共有メモリ内ロック(futex)、定義しない場合はファイルロック(fcntl)
+*          を測定するため、両方でビルドして比較する。
+*
+*          使用方法：LockBench データパス エンティティ名 [最大プロセス数
+*                    [測定時間(秒) [排他ロックの割合(%)]]]
+*          プロセス数は1から最大プロセス数まで倍にしながら測定する
+*
+*    ２  更新履歴
+*          REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+#include <Bench/BenchUtil.h>
+#include <Init/Initializer.h>
+#include <Main/Access.h>
+#include <Manager/Entity.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace SharedMemory;
+
+int main(int argc, char* argv[]) {
+    if(argc < 3) {
+        ::fprintf(stderr, "usage: %s dataPath entity [procs [sec [write%%]]]\n", argv[0]);
+        return 1;
+    }
+    const ::std::string dataPath = argv[1];
+    const ::std::string entity = argv[2];
+    const size_t maxProcs = argc > 3 ? ::strtoul(argv[3], nullptr, 10) : 64;
+    const uint64_t msec = (argc > 4 ? ::strtoul(argv[4], nullptr, 10) : 3) * 1000uL;
+    const uint64_t write = argc > 5 ? ::strtoul(argv[5], nullptr, 10) : 10;
+#ifdef PTHREAD_MUTEX
+    const char* mode = "futex";
+#else
+    const char* mode = "fcntl";
+#endif
+
+    for(size_t procs = 1; procs <= maxProcs; procs *= 2) {
+        Header* tbl = nullptr;
+        const uint64_t total = Bench::runProcesses(procs, msec,
+            [&](size_t) {
+                Access::init(dataPath);
+                auto it = Initializer::table_map.find(entity);
+                if(it == Initializer::table_map.end() || it->second == nullptr) {
+                    ::fprintf(stderr, "エンティティがありません:%s\n", entity.c_str());
+                    ::_exit(1);
+                }
+                tbl = it->second;
+            },
+            [&](size_t, uint64_t i) {
+                // 排他ロックを指定の割合で混ぜる
+                tbl->getLock((i * 37) % 100 < write ? Header::WRITE_LOCK
+                        : Header::READ_LOCK);
+                tbl->releaseLock();
+            });
+        ::printf("%s procs=%zu write=%lu%% ops=%lu ops/s=%.0f\n", mode, procs, write,
+                total, static_cast<double>(total) * 1000.0 / static_cast<double>(msec));
+    }
+    return 0;
+}
@@ -0,0 +1,54 @@
+/**************************************************************************//**
+* @file
+*     モジュール名：共通メモリ管理機能 コミット性能測定
+* <pre>
+*
+*    １  機能
+*          複数プロセスからトランザクションの開始・コミットを繰り返し、
+*          コミットのスループットを測定する。
+*          TRCCの払い出し・公開の競合を測るため、データは更新しない。
+*
+*          使用方法：TransactionBench データパス [最大プロセス数 [測定時間(秒)]]
+*          プロセス数は1から最大プロセス数まで倍にしながら測定する
+*
+*    ２  更新履歴
+*          REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+#include <Bench/BenchUtil.h>
+#include <Main/Access.h>
+#include <Manager/Transaction.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace SharedMemory;
+
+int main(int argc, char* argv[]) {
+    if(argc < 2) {
+        ::fprintf(stderr, "usage: %s dataPath [procs [sec]]\n", argv[0]);
+        return 1;
+    }
+    const ::std::string dataPath = argv[1];
+    const size_t maxProcs = argc > 2 ? ::strtoul(argv[2], nullptr, 10) : 64;
+    const uint64_t msec = (argc > 3 ? ::strtoul(argv[3], nullptr, 10) : 3) * 1000uL;
+
+    for(size_t procs = 1; procs <= maxProcs; procs *= 2) {
+        const uint64_t total = Bench::runProcesses(procs, msec,
+            [&](size_t) { Access::init(dataPath); },
+            [&](size_t, uint64_t) {
+                Transaction& trn = Transaction::getTrans();
+                trid_t trid = trn.startTr();
+                // リングが一杯ならガベージコレクションしてから再開始
+                while(trid == TRID_MAX) {
+                    Access::autoCollect(true);
+                    trid = trn.startTr();
+                }
+                trn.commitTr(trid);
+            });
+        ::printf("procs=%zu commits=%lu commits/s=%.0f\n", procs, total,
+                static_cast<double>(total) * 1000.0 / static_cast<double>(msec));
+    }
+    return 0;
+}
@@ -12,8 +12,10 @@
 **//*-----1---------2---------3---------4---------5---------6---------7------*/
 #include <Init/Exception.h>
 #include <Entity/AppTable.h>
+#include <algorithm>
 #include <string>
 #include <sys/mman.h>
+#include <sys/vfs.h>
 
 #include "PBase"
 #include "Entity/EntityCache.h"
@@ -31,6 +33,13 @@
 #include <Manager/Transaction.h>
 #include "inc/SHMmacro.h"
 
+#ifdef __linux__
+#include <linux/magic.h>
+#endif
+#ifndef HUGETLBFS_MAGIC
+#define HUGETLBFS_MAGIC 0x958458f6
+#endif
+
 namespace SharedMemory
 {
 using ::std::string;
@@ -38,15 +47,12 @@ using ::Entity::EntityCache;
 using ::Entity::NameMaster;
 using ::Entity::AppTable;
 using ::Entity::IndexName;
-using ::Entity::IndexNameIndexer;
 
 /*--------1---------2---------3---------4---------5---------6---------7---*//**
  *  Staticメンバの前方宣言
 **//*-----1---------2---------3---------4---------5---------6---------7------*/
 Transaction*    Initializer::transaction_addr = nullptr;
                                 ///< 全体管理情報アドレス定義
-Index*          Initializer::index_index_addr = nullptr;
-                                ///< インデックス管理インデックスアドレス定義
 IndexManager*   Initializer::index_addr = nullptr;
                                 ///< インデックス管理情報アドレス定義
 table_map_t     Initializer::table_map;
@@ -140,6 +146,7 @@ string Initializer::getTableName(const string& key, const string& value) {
 *    ２    引数
 *            filename : 共有メモリ設定ファイル名     [入力]
 *            dataPath : 共有メモリデータパス名       [入力]
+*                       ("shm:"で始まる場合はPOSIX共有メモリ)
 *
 *    ３    戻り値
 *            EXECUTE_ERR    : メモリ確保失敗
@@ -164,7 +171,13 @@ void Initializer::createMemory(const string& fileName, const string& dataPath) {
         string idxName;                  // インデックス名
         string idxid;                    // インデックスID
         string idxr;                     // インデクサ名
+        IndexType idxType = INDEX_TREAP; // インデックス種別
+        LayoutType layout = LAYOUT_SPLIT;// 物理配置種別
+        uint32_t gcThreshold = 0;        // 自動GCしきい値(%)
+        size_t sessions = 0;             // セッション数
         size_t line = 0;                 // 〃 (変換後)
+        size_t reserve = 0;              // 確保済み要素数(拡張上限)
+        uint32_t mapOpt = 0;             // マップオプション
         msec_t timeOut = DEFAULT_TIMEOUT;// タイムアウト(ms)
         string memName;                  // 共有メモリ名
         size_t memSize = 0;              // メモリサイズ
@@ -178,7 +191,11 @@ void Initializer::createMemory(const string& fileName, const string& dataPath) {
             if(value.length() > 0) {
                 // トランザクション管理情報最大値を取得(MaxLine)
                 line = getDecimal("MaxLine", value);
-                memSize = Transaction::getSize(line);
+                // 自動GCのリング使用率しきい値を取得(GCThreshold)
+                gcThreshold = getGCThreshold(value, Transaction::DEFAULT_GC_THRESHOLD);
+                // セッション管理配列数を取得(MaxSession)
+                sessions = getMaxSession(value);
+                memSize = Transaction::getSize(line, sessions);
                 memName = Transaction::TRANSACTION_NAME;
                 tblType = TRMNG;
                 break;
@@ -204,14 +221,12 @@ void Initializer::createMemory(const string& fileName, const string& dataPath) {
                 tblType = ENTITY;
                 break;
             }
-            // インデックス管理インデックス設定の場合(IndexMgrIndex)
+            // インデックス管理インデックス設定(IndexMgrIndex)は廃止
+            // インデックス管理情報は版の先頭から辿るため領域は確保しない
             value = FileConfig::getValue(tagset, "IndexMgrIndex");
             if(value.length() > 0) {
-                // インデックス管理インデックス数(MaxLine)
-                line = getDecimal("MaxLine", value);
-                memSize = Index::getSize(line);
-                memName = IndexNameIndexer::INDEXER_NAME;
-                tblType = INDEX;
+                WARN_LOG("IndexMgrIndexは使用しません。設定から削除してください");
+                tblType = MAP;
                 break;
             }
             // インデックス情報設定の場合(Index)
@@ -221,7 +236,15 @@ void Initializer::createMemory(const string& fileName, const string& dataPath) {
                 line = getDecimal("MaxLine", value);
                 // インデックス名を取得(IndexName)
                 idxName =  getTableName("IndexName", value);
-                memSize = Index::getSize(line);
+                // インデックス種別を取得(Type)
+                idxType = getIndexType(value);
+                // 確保済み要素数を取得(ReserveLine)、ハッシュは拡張しない
+                reserve = idxType == INDEX_HASH ? line : getReserveLine(value, line);
+                // 物理配置種別を取得(Layout)
+                layout = getLayoutType(value);
+                // 自動GCの使用率しきい値を取得(GCThreshold)
+                gcThreshold = getGCThreshold(value, 0);
+                memSize = Index::getSize(reserve, idxType, layout);
                 memName = idxName;
                 tblType = INDEX;
                 break;
@@ -235,7 +258,13 @@ void Initializer::createMemory(const string& fileName, const string& dataPath) {
                 entName = getTableName("EntityName", value);
                 // テーブル定義(.so)からテーブルサイズを取得
                 tblSize = EntityCache::getTableDef(entName).size;
-                memSize = Entity::getSize(line, tblSize);
+                // 確保済み要素数を取得(ReserveLine)
+                reserve = getReserveLine(value, line);
+                // 物理配置種別を取得(Layout)
+                layout = getLayoutType(value);
+                // 自動GCの使用率しきい値を取得(GCThreshold)
+                gcThreshold = getGCThreshold(value, 0);
+                memSize = Entity::getSize(reserve, tblSize, layout);
                 memName = entName;
                 tblType = ENTITY;
                 break;
@@ -273,25 +302,32 @@ void Initializer::createMemory(const string& fileName, const string& dataPath) {
         if(tblType != MAP) {
             // ロックタイムアウトの取得
             timeOut = getTimeOut(value);
+            // マップオプションの取得
+            mapOpt = getMapOption(value);
             // 共有メモリを確保する
-            adr = createMemory(path, memSize);
+            adr = createMemory(path, memSize, mapOpt);
             // msync(adr, memory_size, MS_ASYNC);
         }
 
         /* 管理領域毎に初期化処理を切り替える 4---------5---------6-------- ココカラ */
         if (tblType == TRMNG) {
-            static_cast<Transaction*>(adr)->init(memName, timeOut, line);
+            static_cast<Transaction*>(adr)->init(memName, timeOut, line, gcThreshold,
+                    sessions);
             addTable(tblType, memName, adr);
         } else if(tblType == INDEX) {
-            static_cast<Index*>(adr)->init(memName, line);
+            static_cast<Index*>(adr)->init(memName, line, idxType, reserve, layout);
+            static_cast<Index*>(adr)->gc_threshold = gcThreshold;
         } else if(tblType == ENTITY) {
             if(memName == IndexName::ENTITY_NAME) {
                 static_cast<IndexManager*>(adr)->init(memName, line);
             } else {
-                static_cast<Entity*>(adr)->init(memName, line, tblSize);
+                static_cast<Entity*>(adr)->init(memName, line, tblSize, reserve, layout);
+                static_cast<Entity*>(adr)->gc_threshold = gcThreshold;
             }
         }
         /* ココマデ -2---------3---------4------- 管理領域毎に初期化処理を切り替える */
+        // アタッチするプロセスが同じオプションでマップできるよう記録する
+        if(adr != nullptr) adr->setMapOption(mapOpt);
 
         // 共有メモリ名をエンティティ名称マスタに登録する
         if(tblType == INDEX || tblType == ENTITY) {
@@ -325,6 +361,7 @@ void Initializer::createMemory(const string& fileName, const string& dataPath) {
 *
 *    ２    引数
 *            dataPath : 共有メモリデータパス名       [入力]
+*                       ("shm:"で始まる場合はPOSIX共有メモリ)
 *
 *    ３    戻り値
 *            EXECUTE_ERR    : メモリ確保失敗
@@ -418,7 +455,7 @@ void Initializer::detachMemory() {
         Entity* memadr = i->second;
         if(nullptr == memadr) continue;
         int fd = memadr->getFileDiscpriter();
-        size_t size = memadr->getMemorySize();
+        size_t size = getMapSize(fd, memadr->getMemorySize());
         if(::munmap(memadr, size) < 0) RUNTIME_ERROR(i->first << " 共有メモリ解放失敗");
         INFO_LOG(i->first << " 共有メモリ開放実施");
         ::close(fd);
@@ -430,7 +467,7 @@ void Initializer::detachMemory() {
     // 全体管理領域を開放する
     if(transaction_addr != nullptr) {
         int fd = transaction_addr->getFileDiscpriter();
-        size_t size = transaction_addr->getMemorySize();
+        size_t size = getMapSize(fd, transaction_addr->getMemorySize());
         if(::munmap(transaction_addr, size) < 0) RUNTIME_ERROR(Transaction::TRANSACTION_NAME << " 共有メモリ解放失敗");
         INFO_LOG(Transaction::TRANSACTION_NAME << " 共有メモリ開放実施");
         ::close(fd);
@@ -442,7 +479,6 @@ void Initializer::detachMemory() {
 
     index_map.clear();
 
-    index_index_addr = nullptr;
     index_addr = nullptr;
 }
 
@@ -476,8 +512,6 @@ void Initializer::addTable(const Type tblType, const string& tblName, Header* tb
     } else if(tblType != MAP) {
         // ローカルテーブルマップへ登録する
         table_map.emplace(tblName, static_cast<Entity*>(tbl));
-        // インデックス管理インデックス情報ならstaticにも登録する
-        if(tblName == IndexNameIndexer::INDEXER_NAME) index_index_addr = static_cast<Index*>(tbl);
         // インデックス管理情報ならstaticにも登録する
         if(tblName == IndexName::ENTITY_NAME) index_addr = static_cast<IndexManager*>(tbl);
         tbl->attatchLog();
@@ -520,7 +554,9 @@ void Initializer::addIndex(const IndexName& tpl) {
         MULTI_DEFINE("エンティティに対し同じIndexIDが指定されています。"
                 "(Entity:" << name << " IndexID:" << index << ")");
 
-    IndexIndexerName ix = { tpl.index_name.str(), tpl.indexer_name.str() };
+    // インデックス管理情報の版の先頭は共有メモリ上で名前から解決しておく
+    const ::Entity::rowid_t slot = IndexManager::getAddr().attach_root_slot(name, index);
+    IndexIndexerName ix = { tpl.index_name.str(), tpl.indexer_name.str(), slot };
     id.emplace(index, ix);
 }
 
@@ -549,6 +585,151 @@ msec_t Initializer::getTimeOut(const string& value) {
     return timeOut;
 }
 
+/*--------1---------2---------3---------4---------5---------6---------7---*//**
+ *
+ *   関数名 : インデックス種別の取得 (getIndexType)
+ *            文字列から<Type>タグでくくられた範囲のパラメータを取得し、
+ *            インデックス種別(TREAP/BTREE/HASH)として返却する。
+ *            指定がない場合はTREAP
+ *
+ *   引数   : value       : <tag>形式文字列      [入力]
+ *
+ *   戻り値 : インデックス種別
+**//*-----1---------2---------3---------4---------5---------6---------7------*/
+IndexType Initializer::getIndexType(const string& value) {
+    static const char key[] = "Type";
+
+    string type = FileConfig::getValue(value, key);
+    if(type.length() == 0 || type == "TREAP") return INDEX_TREAP;
+    if(type == "BTREE") return INDEX_BTREE;
+    if(type == "HASH") return INDEX_HASH;
+
+    FORMAT_ERROR("インデックス種別の指定が不正です。(" << key << ":" << type << ")");
+}
+
+/*--------1---------2---------3---------4---------5---------6---------7---*//**
+ *
+ *   関数名 : 自動GCしきい値の取得 (getGCThreshold)
+ *            文字列から<GCThreshold>タグでくくられた範囲のパラメータを
+ *            取得し、自動GCを要求する使用率(%)として返却する。
+ *            0は自動GCなし
+ *
+ *   引数   : value       : <tag>形式文字列      [入力]
+ *            dft         : 指定がない場合の値   [入力]
+ *
+ *   戻り値 : 使用率しきい値(0～100)
+**//*-----1---------2---------3---------4---------5---------6---------7------*/
+uint32_t Initializer::getGCThreshold(const string& value, uint32_t dft) {
+    static const char key[] = "GCThreshold";
+
+    if(FileConfig::getValue(value, key).length() == 0) return dft;
+    unsigned long threshold = getDecimal(key, value);
+    if(threshold > 100)
+        FORMAT_ERROR("自動GCしきい値の指定が不正です。(" << key << ":" << threshold << ")");
+    return static_cast<uint32_t>(threshold);
+}
+
+/*--------1---------2---------3---------4---------5---------6---------7---*//**
+ *
+ *   関数名 : セッション数の取得 (getMaxSession)
+ *            文字列から<MaxSession>タグでくくられた範囲のパラメータを
+ *            取得し、同時にアタッチできるプロセス数として返却する。
+ *            指定がない場合はTransaction::DEFAULT_MAX_SESSION
+ *
+ *   引数   : value       : <tag>形式文字列      [入力]
+ *
+ *   戻り値 : セッション数
+**//*-----1---------2---------3---------4---------5---------6---------7------*/
+size_t Initializer::getMaxSession(const string& value) {
+    static const char key[] = "MaxSession";
+
+    if(FileConfig::getValue(value, key).length() == 0)
+        return Transaction::DEFAULT_MAX_SESSION;
+    unsigned long sessions = getDecimal(key, value);
+    if(sessions == 0 || sessions >= (1uL << 31))
+        FORMAT_ERROR("セッション数の指定が不正です。(" << key << ":" << sessions << ")");
+    return sessions;
+}
+
+/*--------1---------2---------3---------4---------5---------6---------7---*//**
+ *
+ *   関数名 : 物理配置種別の取得 (getLayoutType)
+ *            文字列から<Layout>タグでくくられた範囲のパラメータを取得し、
+ *            物理配置種別(SPLIT/ALIGNED/INTERLEAVED)として返却する。
+ *            指定がない場合はSPLIT
+ *
+ *   引数   : value       : <tag>形式文字列      [入力]
+ *
+ *   戻り値 : 物理配置種別
+**//*-----1---------2---------3---------4---------5---------6---------7------*/
+LayoutType Initializer::getLayoutType(const string& value) {
+    static const char key[] = "Layout";
+
+    string type = FileConfig::getValue(value, key);
+    if(type.length() == 0 || type == "SPLIT") return LAYOUT_SPLIT;
+    if(type == "ALIGNED") return LAYOUT_ALIGNED;
+    if(type == "INTERLEAVED") return LAYOUT_INTERLEAVED;
+
+    FORMAT_ERROR("物理配置種別の指定が不正です。(" << key << ":" << type << ")");
+}
+
+/*--------1---------2---------3---------4---------5---------6---------7---*//**
+ *
+ *   関数名 : マップオプションの取得 (getMapOption)
+ *            文字列から<HugePages>・<Populate>・<Lock>タグでくくられた
+ *            範囲のパラメータ(ON/OFF)を取得し、マップオプションとして返却
+ *            する。指定がない場合はOFF
+ *
+ *   引数   : value       : <tag>形式文字列      [入力]
+ *
+ *   戻り値 : マップオプション(Header::MapOptionのビット和)
+**//*-----1---------2---------3---------4---------5---------6---------7------*/
+uint32_t Initializer::getMapOption(const string& value) {
+    static const struct {
+        const char* key;
+        Header::MapOption opt;
+    } keys[] = {
+        {"HugePages", Header::MAP_OPT_HUGE},
+        {"Populate",  Header::MAP_OPT_POPULATE},
+        {"Lock",      Header::MAP_OPT_LOCK}
+    };
+
+    uint32_t ret = 0;
+    for(auto& k : keys) {
+        string flag = FileConfig::getValue(value, k.key);
+        if(flag.length() == 0 || flag == "OFF") continue;
+        if(flag != "ON")
+            FORMAT_ERROR("マップオプションの指定が不正です。(" << k.key << ":"
+                    << flag << ")");
+        ret |= k.opt;
+    }
+    return ret;
+}
+
+/*--------1---------2---------3---------4---------5---------6---------7---*//**
+ *
+ *   関数名 : 確保済み要素数の取得 (getReserveLine)
+ *            文字列から<ReserveLine>タグでくくられた範囲のパラメータを
+ *            取得する。共有メモリはこの要素数分を確保し、MaxLineで使い
+ *            切った場合にこの要素数まで拡張する。
+ *            指定がない場合はMaxLine(拡張しない)
+ *
+ *   引数   : value       : <tag>形式文字列      [入力]
+ *            line        : MaxLine              [入力]
+ *
+ *   戻り値 : 確保済み要素数
+**//*-----1---------2---------3---------4---------5---------6---------7------*/
+size_t Initializer::getReserveLine(const string& value, size_t line) {
+    static const char key[] = "ReserveLine";
+
+    if(FileConfig::getValue(value, key).length() == 0) return line;
+    size_t reserve = getDecimal(key, value);
+    if(reserve < line)
+        FORMAT_ERROR(key << "はMaxLine以上を指定してください。(" << key << ":"
+                << reserve << " MaxLine:" << line << ")");
+    return reserve;
+}
+
 /*--------1---------2---------3---------4---------5---------6---------7---*//**
 *
 *     関数名：プロセス開始時間採取 (getProcTime)
@@ -582,7 +763,9 @@ time_t Initializer::getProcTime(pid_t pid) {
 * <pre>
 *
 *    １    機能
-*            指定したサイズの共有メモリを取得する
+*            指定したサイズの共有メモリを取得する。
+*            サイズを指定した作成時は、既存の内容を破棄してゼロクリア
+*            された領域を返す。サイズ0はアタッチとして既存の内容を使う
 *
 *    ２    引数
 *            file_name      :    ファイル名       [入力]
@@ -595,16 +778,11 @@ time_t Initializer::getProcTime(pid_t pid) {
 *            REV001 : 新規作成
 * </pre>
 **//*-----1---------2---------3---------4---------5---------6---------7------*/
-Header* Initializer::createMemory(const string& fileName, long memSize) {
+Header* Initializer::createMemory(const string& fileName, long memSize,
+        uint32_t mapOpt) {
 
-#ifdef BSD
-    long psize = ::getpagesize();
-#else
-    long psize = ::sysconf(_SC_PAGE_SIZE);
-#endif
-    long size = (memSize / psize + 1) * psize;
     // 共有メモリを確保する
-    int fd = ::open(fileName.c_str(), O_RDWR|O_CREAT, 0666);
+    int fd = openMemory(fileName);
     if(fd < 0) RUNTIME_ERROR("共有メモリ取得失敗(open name=" << fileName << " / size=" << memSize << ")");
 
     struct stat buf;        // ファイルステータス
@@ -615,34 +793,188 @@ Header* Initializer::createMemory(const string& fileName, long memSize) {
         ::close(fd);
         RUNTIME_ERROR("共有メモリ取得失敗(stat name=" << fileName << " / size=" << memSize << ")");
     }
-    if(fsize < size) {
-        /* ファイルの必要サイズ分先にシークし、0を書き込み */
-        /* ファイルのサイズをマップしたいサイズにする為 */
-        if(::lseek(fd, size, SEEK_SET) < 0) {
+    // アタッチ時はファイルの管理領域に記録されたオプションでマップする
+    const bool create = memSize != 0;
+    if(!create) {
+        memSize = fsize;
+        mapOpt = Header::readMapOption(fd);
+    }
+    // hugetlbfs上のファイルはヒュージページ単位で確保する
+    const bool hugetlb = isHugeTlbFs(fd);
+    long size = static_cast<long>(getMapSize(fd, memSize));
+    if(create && fsize > 0) {
+        // 作成時は前回の内容を捨て、ゼロクリアされた領域から始める
+        // (個別管理領域は未初期化の要素エントリをゼロのまま扱う)
+        if(::ftruncate(fd, 0) < 0) {
             ::close(fd);
-            RUNTIME_ERROR("共有メモリ取得失敗(seek name=" << fileName << " / size=" << memSize << ")");
+            RUNTIME_ERROR("共有メモリ取得失敗(ftruncate name=" << fileName << " / size=" << memSize << ")");
         }
-        char c = 0;
-        if(::read( fd, &c, sizeof(c)) < 0) c = 0;
-        if(::write(fd, &c, sizeof(c)) < 0) {
+        fsize = 0;
+    }
+    if(fsize < size) {
+        // hugetlbfsはwriteできないため、ftruncateでファイルサイズを広げる
+        if(::ftruncate(fd, size) < 0) {
             ::close(fd);
-            RUNTIME_ERROR("共有メモリ取得失敗(write name=" << fileName << " / size=" << memSize << ")");
+            RUNTIME_ERROR("共有メモリ取得失敗(ftruncate name=" << fileName << " / size=" << memSize << ")");
         }
     }
-    if(memSize == 0) memSize = fsize;
 
-    Header* adr = reinterpret_cast<Header*>(::mmap(0, memSize, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0));
+    // ヒュージページをmadviseで指定する場合は、指定後に事前フォールトする
+    const bool advise = (mapOpt & Header::MAP_OPT_HUGE) && !hugetlb;
+    int flags = MAP_SHARED;
+    if((mapOpt & Header::MAP_OPT_POPULATE) && !advise) flags |= MAP_POPULATE;
+    const size_t mapSize = hugetlb ? static_cast<size_t>(size) : static_cast<size_t>(memSize);
+
+    Header* adr = reinterpret_cast<Header*>(::mmap(0, mapSize, PROT_READ|PROT_WRITE, flags, fd, 0));
     if(adr == MAP_FAILED || adr == nullptr) {
         ::close(fd);
         RUNTIME_ERROR("共有メモリ取得失敗(mmap name=" << fileName << " / size=" << memSize << ")");
     }
+    if(advise) {
+#ifdef MADV_HUGEPAGE
+        // 共有メモリのTHPはshmem_enabledがadvise以上の場合のみ有効
+        if(::madvise(adr, mapSize, MADV_HUGEPAGE) < 0)
+            WARN_LOG("ヒュージページ指定失敗(madvise name=" << fileName << ")");
+#else
+        WARN_LOG("ヒュージページ未対応(name=" << fileName << ")");
+#endif
+        if(mapOpt & Header::MAP_OPT_POPULATE) populateMemory(adr, mapSize);
+    }
+    if(mapOpt & Header::MAP_OPT_LOCK) {
+        // RLIMIT_MEMLOCKを超える場合はロックせずに続行する
+        if(::mlock(adr, mapSize) < 0)
+            WARN_LOG("メモリロック失敗(mlock name=" << fileName << " / size=" << mapSize << ")");
+    }
     // ファイルディスクプリタを設定する
     adr->setFileDiscpriter(fd);
 
-    TRACE_LOG("共有メモリ取得成功(mmap name=" << fileName << " / size=" << memSize << ")");
+    TRACE_LOG("共有メモリ取得成功(mmap name=" << fileName << " / size=" << memSize
+            << " / option=" << mapOpt << (hugetlb ? " / hugetlbfs" : "") << ")");
 
     return adr;
 }
 
+/*--------1---------2---------3---------4---------5---------6---------7---*//**
+*
+*     関数名：共有メモリオープン (openMemory)
+* <pre>
+*
+*    １    機能
+*            共有メモリの実体をオープンする(なければ作成する)。
+*            データパスが"shm:"で始まる場合はPOSIX共有メモリ(shm_open)を
+*            使い、ブロックデバイスに書き戻さない。名前は"shm:"以降の
+*            パスの'/'を'.'に置き換えたものとする
+*            (例 shm:mydb/SHM::XXX.table → /mydb.SHM::XXX.table)。
+*            それ以外はデータパス上の通常ファイルを使う
+*
+*    ２    引数
+*            file_name      :    ファイル名       [入力]
+*
+*    ３    戻り値
+*            ファイルディスクプリタ(失敗時はマイナス値)
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//*-----1---------2---------3---------4---------5---------6---------7------*/
+int Initializer::openMemory(const string& fileName) {
+    if(fileName.compare(0, Header::SHM_PREFIX.length(), Header::SHM_PREFIX) != 0)
+        return ::open(fileName.c_str(), O_RDWR|O_CREAT, 0666);
+
+    string name = fileName.substr(Header::SHM_PREFIX.length());
+    // 先頭の'/'を除き、残りの'/'は名前に使えないため'.'に置き換える
+    name.erase(0, name.find_first_not_of('/'));
+    ::std::replace(name.begin(), name.end(), '/', '.');
+    return ::shm_open(("/" + name).c_str(), O_RDWR|O_CREAT, 0666);
+}
+
+/*--------1---------2---------3---------4---------5---------6---------7---*//**
+*
+*     関数名：hugetlbfs判定 (isHugeTlbFs)
+* <pre>
+*
+*    １    機能
+*            共有メモリファイルがhugetlbfs上にあるかを判定する
+*
+*    ２    引数
+*            fd             :    ファイルディスクプリタ   [入力]
+*
+*    ３    戻り値
+*            true  : hugetlbfs
+*            false : それ以外
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//*-----1---------2---------3---------4---------5---------6---------7------*/
+bool Initializer::isHugeTlbFs(int fd) {
+    struct statfs fs;
+    if(::fstatfs(fd, &fs) != 0) return false;
+    return static_cast<unsigned long>(fs.f_type) == HUGETLBFS_MAGIC;
+}
+
+/*--------1---------2---------3---------4---------5---------6---------7---*//**
+*
+*     関数名：マップサイズ取得 (getMapSize)
+* <pre>
+*
+*    １    機能
+*            メモリサイズをページ境界に切り上げる。hugetlbfs上のファイルは
+*            ヒュージページ境界に切り上げる(mmap・munmapとも同じ長さとする)
+*
+*    ２    引数
+*            fd             :    ファイルディスクプリタ   [入力]
+*            memory_size    :    メモリサイズ             [入力]
+*
+*    ３    戻り値
+*            マップサイズ
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//*-----1---------2---------3---------4---------5---------6---------7------*/
+size_t Initializer::getMapSize(int fd, size_t memSize) {
+    struct statfs fs;
+    if(isHugeTlbFs(fd) && ::fstatfs(fd, &fs) == 0) {
+        const size_t hsize = static_cast<size_t>(fs.f_bsize);
+        return (memSize + hsize - 1) / hsize * hsize;
+    }
+#ifdef BSD
+    size_t psize = ::getpagesize();
+#else
+    size_t psize = ::sysconf(_SC_PAGE_SIZE);
+#endif
+    return (memSize + psize - 1) / psize * psize;
+}
+
+/*--------1---------2---------3---------4---------5---------6---------7---*//**
+*
+*     関数名：事前フォールト (populateMemory)
+* <pre>
+*
+*    １    機能
+*            マップした領域の全ページを書込みでフォールトさせる。
+*            MADV_POPULATE_WRITEが使えない場合はページ毎に読み書きする
+*
+*    ２    引数
+*            adr            :    先頭アドレス   [入力]
+*            size           :    サイズ         [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//*-----1---------2---------3---------4---------5---------6---------7------*/
+void Initializer::populateMemory(void* adr, size_t size) {
+#ifdef MADV_POPULATE_WRITE
+    if(::madvise(adr, size, MADV_POPULATE_WRITE) == 0) return;
+#endif
+    const size_t psize = static_cast<size_t>(::sysconf(_SC_PAGE_SIZE));
+    volatile char* p = static_cast<volatile char*>(adr);
+    for(size_t off = 0; off < size; off += psize) p[off] = p[off];
+}
+
 /*--------1---------2---------3---------4---------5---------6---------7------*/
 }  // namespace SharedMemory
@@ -20,6 +20,7 @@
 #include <set>
 #include <string>
 
+#include "inc/SHMConst.h"
 
 namespace SharedMemory
 {
@@ -37,10 +38,11 @@ class IndexIndexerName {
 public:
     const ::std::string index_name;
     const ::std::string indexer_name;
+    const ::Entity::rowid_t root_slot;  ///< インデックス管理情報の版の先頭番号
 
     IndexIndexerName(const ::std::string& index_name,
-            const ::std::string& indexer_name) :
-        index_name(index_name), indexer_name(indexer_name) { }
+            const ::std::string& indexer_name, ::Entity::rowid_t root_slot) :
+        index_name(index_name), indexer_name(indexer_name), root_slot(root_slot) { }
 };
 
 /// インデックスIDマップ
@@ -77,6 +79,26 @@ private:
     static void addIndex(const ::Entity::IndexName&);
     /// タイムアウト値の取得
     static uint64_t getTimeOut(const ::std::string&);
+    /// インデックス種別の取得
+    static IndexType getIndexType(const ::std::string&);
+    /// 物理配置種別の取得
+    static LayoutType getLayoutType(const ::std::string&);
+    /// 自動GCしきい値の取得
+    static uint32_t getGCThreshold(const ::std::string&, uint32_t);
+    /// セッション数の取得
+    static size_t getMaxSession(const ::std::string&);
+    /// 確保済み要素数の取得
+    static size_t getReserveLine(const ::std::string&, size_t);
+    /// マップオプションの取得
+    static uint32_t getMapOption(const ::std::string&);
+    /// 共有メモリオープン
+    static int openMemory(const ::std::string&);
+    /// hugetlbfs判定
+    static bool isHugeTlbFs(int);
+    /// マップサイズ取得
+    static size_t getMapSize(int, size_t);
+    /// 事前フォールト
+    static void populateMemory(void*, size_t);
 
 public:
     /// 共有メモリ初期化
@@ -94,12 +116,10 @@ public:
     static index_map_t index_map;
     /// 全体管理情報アドレス
     static Transaction* transaction_addr;
-    /// インデックス管理インデックスアドレス
-    static Index* index_index_addr;
     /// インデックス管理情報アドレス
     static IndexManager* index_addr;
 private:
-    static Header* createMemory(const std::string&, long);
+    static Header* createMemory(const std::string&, long, uint32_t = 0);
 };
 
 /*--------1---------2---------3---------4---------5---------6---------7------*/
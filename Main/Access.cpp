@@ -14,6 +14,7 @@
 #include <Main/Access.h>
 #include <Main/Connection.h>
 #include <Main/Cursor.h>
+#include <Main/GarbageCollector.h>
 #include <Manager/Entity.h>
 #include <Manager/Transaction.h>
 #include <map>
@@ -27,6 +28,8 @@ using ::std::string;
 using ::Entity::rowid_t;
 
 Connection Access::connection;
+GarbageCollector Access::auto_gc;
+::std::mutex Access::auto_gc_mutex;
 /**************************************************************************//**
 *
 *     関数名：共有メモリ管理機能初期化・システムモニタ用 (init)
@@ -34,7 +37,7 @@ Connection Access::connection;
 *
 *    １    機能
 *            共有メモリ管理情報を割り当てて、エンティティ名称マスタへ登録
-*            する
+*            する。自プロセスのセッションを登録する
 *
 *    ２    引数
 *            fileName  : 共有メモリ設定ファイル名     [入力]
@@ -51,6 +54,7 @@ Connection Access::connection;
 void Access::init(const string& fileName, const string& dataPath) {
 
     Initializer::createMemory(fileName, dataPath);
+    Transaction::getTrans().attachSession();
 
 }
 
@@ -61,7 +65,9 @@ void Access::init(const string& fileName, const string& dataPath) {
 *
 *    １    機能
 *            エンティティ名称マスタから管理情報をとりだして仮想メモリに
-*            割り当てる
+*            割り当て、自プロセスのセッションを登録する。
+*            呼び出したスレッドは終了までセッションを保持するため、
+*            アタッチ中存続するスレッドから呼び出すこと
 *
 *    ２    引数
 *            dataPath : 共有メモリデータパス名       [入力]
@@ -77,6 +83,7 @@ void Access::init(const string& fileName, const string& dataPath) {
 void Access::init(const string& dataPath) {
 
     Initializer::attachMemory(dataPath);
+    Transaction::getTrans().attachSession();
 
 }
 /**************************************************************************//**
@@ -85,7 +92,8 @@ void Access::init(const string& dataPath) {
 * <pre>
 *
 *    １    機能
-*            共有メモリ管理情報を全て開放し、終了可能状態とする
+*            セッションを解除し、共有メモリ管理情報を全て開放して、
+*            終了可能状態とする
 *
 *    ２    引数
 *            なし
@@ -100,6 +108,8 @@ void Access::init(const string& dataPath) {
 **//**************************************************************************/
 void Access::destroy() {
     connection.close();
+    if(Initializer::transaction_addr != nullptr)
+        Transaction::getTrans().detachSession();
     Initializer::detachMemory();
 }
 
@@ -131,10 +141,11 @@ Connection& Access::getConnection() {
 * <pre>
 *
 *    １    機能
-*            共有メモリ管理領域のガベージコレクションを実施する
+*            共有メモリ管理領域のガベージコレクションを1サイクル実施する。
+*            上限付きで少しずつ実行する場合はGarbageCollectorを使う
 *
 *    ２    引数
-*            なし
+*            workers   : 並列に回収するスレッド数(省略時は1)   [入力]
 *
 *    ３    戻り値
 *            EXECUTE_OK : 成功
@@ -144,106 +155,46 @@ Connection& Access::getConnection() {
 *            REV001 : 新規作成
 * </pre>
 **//**************************************************************************/
-void Access::executeGarbageCollection() {
-
-    Transaction& trn = Transaction::getTrans();
-
-    trn.getLock(Header::WRITE_LOCK);
-
-    // プロセスの生存チェック
-    for(trid_t trid = trn.trid_collecting; trid < trn.trid_next; trid++) {
-        Transaction::Recode& tr = trn.getTransaction(trid);
-        // IN_PROGRESS以外は処理しない。
-        if(tr.status != Transaction::IN_PROGRESS)
-            continue;
-        // 対象プロセスの開始時刻を取得
-        time_t time = Initializer::getProcTime(tr.pid);
-        // プロセスが存在しない場合、ステータスを変更する。
-        if(time == -1 || time != tr.pid_time) {
-            tr.status = Transaction::ABORTED;
-        }
-    }
-    trn.releaseLock();
-
-    trn.getLock(Header::READ_LOCK);
-    // IN_PROGRESSのTRIDの下限を確認する
-    trid_t tridInProg = trn.trid_collecting;
-    for(trid_t next = trn.trid_next; tridInProg < next; tridInProg++) {
-        // IN_PROGRESSの場合でもpidに該当するプロセスがいない場合は
-        // ABORTEDとみなす
-        Transaction::Recode& tr = trn.getTransaction(tridInProg);
-        if(tr.status == Transaction::IN_PROGRESS) break;
-    }
-    // 回収可能なTRIDの範囲を確認する
-    trid_t newTridColl = trn.trid_collecting;
-    for(trid_t next = trn.trid_next; newTridColl < next; newTridColl++) {
-        Transaction::Recode& tr = trn.getTransaction(newTridColl);
-        // IN_PROGRESSの場合でもpidに該当するプロセスがいない場合は
-        // ABORTEDとみなす
-        if(tr.status == Transaction::IN_PROGRESS
-                || (tr.status == Transaction::COMMITTED && tridInProg < tr.trid_end))
-                break; // IN_PROGRESSのTrから参照される可能性がある
-    }
-    trn.releaseLock();
-
-    // 回収可能なTRIDを開放する
-    for(auto it = Initializer::table_map.begin(); it != Initializer::table_map.end(); it++) {
-        Entity* tbl = it->second;
-        if(nullptr == tbl) {
-            WARN_LOG("テーブル情報がnullです:" << it->first);
-            continue;
-        }
-
-        tbl->getLock(Header::WRITE_LOCK);
+void Access::executeGarbageCollection(size_t workers) {
 
-        size_t collected = 0; // DEBUG
-        size_t remained = 0;  // DEBUG
-        for(rowid_t rowid = 0, end = tbl->used_end; rowid < end; rowid++) {
-            Entity::Entry& ent = tbl->getEntry(rowid);
-            if(trn.trid_collecting <= ent.xmin && ent.xmin < newTridColl) {
-                Transaction::Recode& tr = trn.getTransaction(ent.xmin);
+    // 上限なしで1サイクル実行する(ロックはブロック毎に取り直す)
+    GarbageCollector gc(0, 0);
+    gc.collect_parallel(workers);
 
-                trn.getLock(Header::READ_LOCK);
-                if(tr.status != Transaction::COMMITTED) {
-                    trn.releaseLock();
-                    tbl->freeTuple(rowid);
-                    collected++; // DEBUG
-                    continue;
-                }
-                trn.releaseLock();
-            }
-            if(trn.trid_collecting <= ent.xmax && ent.xmax < newTridColl) {
-                Transaction::Recode& tr = trn.getTransaction(ent.xmax);
+    return;
+}
 
-                trn.getLock(Header::READ_LOCK);
-                if(tr.status == Transaction::COMMITTED) {
-                    trn.releaseLock();
-                    tbl->freeTuple(rowid);
-                    collected++; // DEBUG
-                    continue;
-                } else {
-                    trn.releaseLock();
-                    ent.xmax = TRID_MAX;
-                }
-            }
-            trn.getLock(Header::READ_LOCK);
-            if (trn.trid_collecting <= ent.lock && ent.lock < newTridColl)
-                ent.lock = TRID_MAX;
-            trn.releaseLock();
-            remained++;
-        }
-        // DEBUG
-        INFO_LOG("[GC] %s : total=%lu used_end=%lu free_begin=%lu "
-                "collected=%lu remained=%lu",
-                tbl->getName(), tbl->getMaxLine(), tbl->used_end,
-                tbl->free_begin, collected, remained);
-        tbl->releaseLock();
-    }
-    trn.getLock(Header::WRITE_LOCK);
-    trn.trid_collecting = newTridColl;
-    trn.releaseLock();
+/**************************************************************************//**
+*
+*     関数名：自動ガベージコレクション (autoCollect)
+* <pre>
+*
+*    １    機能
+*            GC要求を受けて、呼出し元でガベージコレクションを実施する。
+*            通常は上限付きで1ステップ、リングに空きがない場合は1サイクル
+*            実施する。サイクルは全プロセスで1つとし、所有はサイクルの
+*            開始から終了まで(ステップの間も)保持する(GarbageCollector::
+*            begin_cycle)。常駐GC・他プロセスがサイクルを実行中なら何もせず、
+*            所有者のセッションが終了したか進捗がなければ引き継ぐ。
+*            プロセス内では自動GCを同時に1スレッドのみ実行し、他のスレッド
+*            が実行中なら何もしない
+*
+*    ２    引数
+*            full      : true=1サイクル、false=1ステップ    [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void Access::autoCollect(bool full) {
+    ::std::unique_lock<::std::mutex> lock(auto_gc_mutex, ::std::try_to_lock);
+    if(!lock.owns_lock()) return;
 
-    return;
+    if(full) auto_gc.collect();
+    else auto_gc.step();
 }
 
 /*--------1---------2---------3---------4---------5---------6---------7------*/
@@ -15,6 +15,7 @@
 #define SharedMemory_ACCESS_H_
 
 #include <map>
+#include <mutex>
 #include <vector>
 #include <string>
 
@@ -23,6 +24,7 @@
 namespace SharedMemory
 {
 class Connection;
+class GarbageCollector;
 /**************************************************************************//**
 *
 *     クラス名：共通メモリ管理機能基底クラス (CSMAccess)
@@ -41,11 +43,16 @@ public:
     static void init(const ::std::string&);             ///< 初期化(その他プロセス用)
     static void destroy();                     ///< 終了
     static Connection& getConnection();    ///< コネクション取得
-    static void executeGarbageCollection();    ///< ガベージコレクション
+    static void executeGarbageCollection(size_t = 1);  ///< ガベージコレクション
+    static void autoCollect(bool);             ///< 自動ガベージコレクション
 
 private:
     /// コネクションオブジェクト
     static Connection connection;
+    /// 自動GC(プロセス単位で走査位置を保持する)
+    static GarbageCollector auto_gc;
+    /// 自動GCの排他(プロセス内のスレッド間)
+    static ::std::mutex auto_gc_mutex;
     Access();                               ///< コンストラクタなし
 };
 /*--------1---------2---------3---------4---------5---------6---------7------*/
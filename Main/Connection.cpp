@@ -12,8 +12,10 @@
 **//**************************************************************************/
 #include <Init/Exception.h>
 #include <Init/Initializer.h>
+#include <Main/Access.h>
 #include <Main/Connection.h>
 #include <Main/Cursor.h>
+#include <Manager/IndexIterator.h>
 #include <Manager/IndexManager.h>
 #include <Manager/Transaction.h>
 #include <sys/time.h>
@@ -64,7 +66,7 @@ Connection::Connection() {
 * <pre>
 *
 *    １    機能
-*            特になし
+*            未使用の予約要素を空きに戻す
 *
 *    ２    引数
 *            なし
@@ -78,6 +80,12 @@ Connection::Connection() {
 **//**************************************************************************/
 Connection::~Connection() {
 //    this->close();
+    // 未使用の予約要素を空きに戻す(デストラクタからは例外を送出しない)
+    try {
+        IndexManager::release_slots(slot_reserves);
+    } catch(...) {
+        WARN_LOG("予約要素を空きに戻せませんでした");
+    }
 }
 
 /**************************************************************************//**
@@ -115,8 +123,7 @@ Cursor& Connection::openCursor(AppTable& data, const bool flag,
 
     // 更新ロックフラグがONなら更新ロックをとる
     if(flag) {
-        // TODO(ロック開放待ちはここで行う必要がある)
-        for(msec_t start = msecGet(); timeCheck(start); sleep()) {
+        for(msec_t start = msecGet(); timeCheck(start); wait(start)) {
             cur->setErrorCode(EXECUTE_TIMEOUT);
             // トランザクション調整
             adjustTransaction();
@@ -125,7 +132,7 @@ Cursor& Connection::openCursor(AppTable& data, const bool flag,
                 try {
                     // インデックス検索処理
                     IndexManager::search_tuples(cur->getRowIDs(), flag,
-                            trid, data.getTableName(), idxMtcr, dftMtcr, sorter);
+                            trid, index_roots, data.getTableName(), idxMtcr, dftMtcr, sorter);
                     // リターンコードがタイムアウトなら引き続きスリープする
                 } catch(::Exception::timeout& e) {
                     continue;
@@ -139,9 +146,66 @@ Cursor& Connection::openCursor(AppTable& data, const bool flag,
         adjustTransaction();
         // インデックス検索処理
         IndexManager::search_tuples(cur->getRowIDs(), flag,
-                trid, data.getTableName(), idxMtcr, dftMtcr, sorter);
+                trid, index_roots, data.getTableName(), idxMtcr, dftMtcr, sorter);
+    }
+
+    return *cur;
+}
+
+/**************************************************************************//**
+*
+*     関数名：逐次カーソルオープン (openStreamCursor)
+* <pre>
+*
+*    １    機能
+*            指定した条件に沿った逐次カーソルオブジェクトを作成する。
+*            検索結果を展開せず、フェッチ毎にインデックスを辿るため、
+*            最初のフェッチまでの時間と使用メモリが件数に依存しない。
+*            結果はインデックス順となる。更新ロックはフェッチ時に取得する。
+*            マッチャはカーソルを閉じるまで呼出し元で保持すること
+*
+*    ２    引数
+*            data           : フェッチ対象のデータ
+*            bLockFlag      : 更新ロック取得フラグ
+*            IndexMatcher   : インデックスマッチャ
+*            DefaultMatcher : デフォルトマッチャ
+*
+*    ３    戻り値
+*            カーソルオブジェクトを返却する
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+Cursor& Connection::openStreamCursor(AppTable& data, const bool flag,
+        AbstIndexMatcher* idxMtcr, const ImplMatcher* dftMtcr) {
+
+    // トランザクションを取得
+    getTransaction();
+
+    IndexIterator* itr = nullptr;
+    if(flag) {
+        for(msec_t start = msecGet(); timeCheck(start); wait(start)) {
+            // トランザクション調整
+            adjustTransaction();
+            // index_rootの更新ロックを取得
+            if(IndexManager::lock_index_root(data.getTableName(), trid)) {
+                itr = IndexManager::open_tuples(flag, trid, index_roots,
+                        data.getTableName(), idxMtcr, dftMtcr);
+                break;
+            }
+        }
+    } else {
+        // トランザクション調整
+        adjustTransaction();
+        itr = IndexManager::open_tuples(flag, trid, index_roots,
+                data.getTableName(), idxMtcr, dftMtcr);
     }
 
+    Cursor* cur = new Cursor(data, itr);    // カーソルオブジェクト作成
+    cursor_vct.push_back(cur);
+    if(itr == nullptr) cur->setErrorCode(EXECUTE_TIMEOUT);
+
     return *cur;
 }
 
@@ -170,16 +234,16 @@ int Connection::executeInsert(AppTable& data) {
     // トランザクションを取得
     getTransaction();
 
-    // TODO(ロック開放待ちはここで行う必要がある)
-    for(msec_t start = msecGet(); timeCheck(start); sleep()) {
+    for(msec_t start = msecGet(); timeCheck(start); wait(start)) {
         // トランザクション調整
         adjustTransaction();
         // index_rootの更新ロックを取得
         if(IndexManager::lock_index_root(data.getTableName(), trid)) {
             try {
                 // データ挿入処理
-                IndexManager::insert_tuple(trid, data.getTableName(),
-                        data.getData(), data.getTableSize());//TODO
+                IndexManager::insert_tuple(trid, index_roots, slot_reserves,
+                        data.getTableName(), data.getData(),
+                        data.getTableSize());//TODO
             } catch(::Exception::timeout& e) {
                 continue;
             }
@@ -220,18 +284,18 @@ int Connection::executeUpdate(AppTable& data, AbstIndexMatcher* idxMtcr,
     // トランザクションを取得
     getTransaction();
 
-    // TODO(ロック開放待ちはここで行う必要がある)
-    for(msec_t start = msecGet(); timeCheck(start); sleep()) {
+    for(msec_t start = msecGet(); timeCheck(start); wait(start)) {
         // トランザクション調整
         adjustTransaction();
         // index_rootの更新ロックを取得
         if(IndexManager::lock_index_root(data.getTableName(), trid)) {
             try {
                 // 対象を削除
-                IndexManager::delete_tuples(trid, data.getTableName(), idxMtcr, dftMtcr);
+                IndexManager::delete_tuples(trid, index_roots, data.getTableName(), idxMtcr, dftMtcr);
                 // 削除が成功したら、指定データを追加登録
-                IndexManager::insert_tuple(trid, data.getTableName(),
-                        data.getData(), data.getTableSize());//TODO
+                IndexManager::insert_tuple(trid, index_roots, slot_reserves,
+                        data.getTableName(), data.getData(),
+                        data.getTableSize());//TODO
                 // 戻り値がエラーだったらその戻り値で上書きする
             } catch(::Exception::timeout& e) {
                 continue;
@@ -269,15 +333,14 @@ int Connection::executeDelete(const string& entName, AbstIndexMatcher* idxMtcr,
 
     getTransaction();
 
-    // TODO(ロック開放待ちはここで行う必要がある)
-    for(msec_t start = msecGet(); timeCheck(start); sleep()) {
+    for(msec_t start = msecGet(); timeCheck(start); wait(start)) {
         // トランザクション調整
         adjustTransaction();
         // index_rootの更新ロックを取得
         if(IndexManager::lock_index_root(entName, trid)) {
             try {
                 // 対象を削除
-                IndexManager::delete_tuples(trid, entName, idxMtcr, dftMtcr);
+                IndexManager::delete_tuples(trid, index_roots, entName, idxMtcr, dftMtcr);
             } catch(::Exception::timeout& e) {
                 continue;
             }
@@ -295,7 +358,8 @@ int Connection::executeDelete(const string& entName, AbstIndexMatcher* idxMtcr,
 *
 *    １    機能
 *            トランザクションを確定する。
-*            トランザクションが無くてもなにもしない
+*            トランザクションが無くてもなにもしない。
+*            開いている逐次カーソルは閉じ、未使用の予約要素は空きに戻す
 *
 *    ２    引数
 *            なし
@@ -310,11 +374,15 @@ int Connection::executeDelete(const string& entName, AbstIndexMatcher* idxMtcr,
 **//**************************************************************************/
 void Connection::commitTransaction() {
     if(trid != TRID_MAX) {
-        Transaction& trn = Transaction::getTrans();
-        trn.getLock(Header::WRITE_LOCK);
-        trn.commitTr(trid);
-        trn.releaseLock();
+        // Tr内で更新したインデックスルートを反映してからコミットする
+        IndexManager::flush_index_roots(trid, index_roots);
+        Transaction::getTrans().commitTr(trid);
     }
+    // 逐次カーソルは終了したTrのスナップショットで走査しているため閉じる
+    closeStreamCursors();
+    // 未使用の予約要素は空きに戻す(予約はTr内でのみ保持する)
+    IndexManager::release_slots(slot_reserves);
+    index_roots.clear();
     trid = TRID_MAX;
 }
 /**************************************************************************//**
@@ -324,7 +392,8 @@ void Connection::commitTransaction() {
 *
 *    １    機能
 *            トランザクションを無効化する。
-*            トランザクションが無くてもなにもしない
+*            トランザクションが無くてもなにもしない。
+*            開いている逐次カーソルは閉じ、未使用の予約要素は空きに戻す
 *
 *    ２    引数
 *            なし
@@ -339,11 +408,13 @@ void Connection::commitTransaction() {
 **//**************************************************************************/
 void Connection::rollbackTransaction() {
     if(trid != TRID_MAX) {
-        Transaction& trn = Transaction::getTrans();
-        trn.getLock(Header::WRITE_LOCK);
-        trn.abortTr(trid);
-        trn.releaseLock();
+        Transaction::getTrans().abortTr(trid);
     }
+    // 逐次カーソルは終了したTrのスナップショットで走査しているため閉じる
+    closeStreamCursors();
+    // 未使用の予約要素は空きに戻す(予約はTr内でのみ保持する)
+    IndexManager::release_slots(slot_reserves);
+    index_roots.clear();
     trid = TRID_MAX;
 }
 /**************************************************************************//**
@@ -378,6 +449,9 @@ void Connection::close() {
     }
     this->cursor_vct.clear();
 
+    // 未使用の予約要素を空きに戻す
+    IndexManager::release_slots(slot_reserves);
+
     this->trid = TRID_MAX;
 
 }
@@ -443,7 +517,9 @@ const Connection::IsolationLevel Connection::getIsolationLevel() const {
 * <pre>
 *
 *    １    機能
-*            トランザクションIDを取得する
+*            トランザクションIDを取得する。
+*            GC要求中で常駐GCがなければ、取得前に1ステップ回収する。
+*            リングに空きがなければ1サイクル回収してから空きを待ち合わせる
 *
 *    ２    引数
 *            なし
@@ -461,22 +537,21 @@ void Connection::getTransaction() {
     if(this->trid != TRID_MAX) return;
 
     Transaction& trn = Transaction::getTrans();
-
-    for(msec_t start = msecGet(); timeCheck(start); sleep()) {
-        // 全体管理領域で排他ロックを取得する
-        trn.getLock(Header::WRITE_LOCK);
-        // collectingとnextの差がmax_line以下ならトランザクション取得可能
-        if(trn.trid_next - trn.trid_collecting < trn.getMaxLine()) {
-            // 新しいトランザクションの取得
-            trid = trn.startTr();
-            // ロックを開放する
-            trn.releaseLock();
-
-            return;
-        }
-        // ロックを開放する
-        trn.releaseLock();
-        // 取得不能の場合はスリープしてループ
+    // しきい値超過のGC要求があり常駐GCがなければ、ここで1ステップ回収する
+    if(trn.isGCRequested() && !trn.hasGCWorker()) Access::autoCollect(false);
+
+    // 新しいトランザクションの取得
+    // collectingとnextの差がmax_line以上ならTRID_MAXが返る
+    trid = trn.startTr();
+    if(trid != TRID_MAX) return;
+    // リングに空きがなければ、常駐GCの有無によらず一度だけここで回収する
+    // (他がサイクルを実行中なら何もせず、その終了による空きを待つ)
+    Access::autoCollect(true);
+
+    for(msec_t start = msecGet(); timeCheck(start); wait(start)) {
+        trid = trn.startTr();
+        if(trid != TRID_MAX) return;
+        // 取得不能の場合は空きを待ち合わせてループ
     }
     TIMEOUT("トランザクションタイムアウト");
 }
@@ -488,7 +563,7 @@ void Connection::getTransaction() {
 *
 *    １    機能
 *           Read Committed時のトランザクション調整処理
-*           インデックスルート、コミットカウント現在値をとりなおす
+*           コミットカウント現在値をとりなおす
 *
 *    ２    引数
 *            なし
@@ -506,22 +581,45 @@ void Connection::adjustTransaction() {
     Transaction& trn = Transaction::getTrans();
     Transaction::Recode& tr = trn.getTransaction(trid);
 
-    // 全体管理領域で排他ロックを取得する
-    trn.getLock(Header::WRITE_LOCK);
     // コミットカウント現在値の保存
-    tr.trcc_begin = trn.trcc_next;
-    // インデックスルート書き換え
-    if(IndexManager::is_index_root_valid(trid, trn.index_root_master)) {
-        TRACE_LOG("(trid:" << trid << ") MASTERroot:" << trn.index_root_master
-                << " -> TRNroot:" << tr.index_root);
-        tr.index_root = trn.index_root_master;
-    }
-    // ロックを開放する
-    trn.releaseLock();
+    // インデックスルートはエンティティ毎の管理情報をこの値で可視判定する
+    tr.trcc_begin = trn.trcc_next.load();
+    // 更新していないインデックスルートは新しいTRCCで取り直す
+    IndexManager::refresh_index_roots(index_roots);
 
     return;
 }
 
+/**************************************************************************//**
+*
+*     関数名：逐次カーソルのクローズ(closeStreamCursors)
+* <pre>
+*
+*    １    機能
+*           Tr終了時に、開いている逐次カーソルを閉じる。
+*           逐次カーソルはフェッチ毎に開始時のTrIDで可視判定するため、
+*           Tr終了後は使用できない。カーソルオブジェクトは利用者が参照して
+*           いるため開放せず、以降のフェッチは終了(エラーコードEXECUTE_ERR)
+*           とする
+*
+*    ２    引数
+*            なし
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void Connection::closeStreamCursors() {
+    for(auto i = cursor_vct.begin(); i != cursor_vct.end(); i++) {
+        if(*i == nullptr || !(*i)->isStream()) continue;
+        (*i)->close();
+        (*i)->setErrorCode(EXECUTE_ERR);
+    }
+}
+
 /**************************************************************************//**
 *
 *     関数名：システム時間取得 (msecGet)
@@ -570,8 +668,32 @@ bool Connection::timeCheck(msec_t start) {
     return (msecGet() - start) < trn.getTimeOut() || trn.getTimeOut() == 0;
 }
 
-void Connection::sleep() {
-    ::usleep(Transaction::getTrans().getTimeOut() * 100);
+/**************************************************************************//**
+*
+*     関数名：再試行待ち合わせ (wait)
+* <pre>
+*
+*    １    機能
+*            書込み不可の原因となったトランザクションの終了を、開始時刻から
+*            のタイムアウト期限まで待ち合わせる
+*
+*    ２    引数
+*            start  : 開始時刻
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void Connection::wait(msec_t start) {
+    Transaction& trn = Transaction::getTrans();
+    msec_t timeout = trn.getTimeOut();
+    msec_t elapsed = msecGet() - start;
+    // 期限切れは呼出し元のtimeCheckで判定する
+    if(timeout != 0 && elapsed >= timeout) return;
+    trn.waitTr(timeout == 0 ? 0 : timeout - elapsed);
 }
 
 /*--------1---------2---------3---------4---------5---------6---------7------*/
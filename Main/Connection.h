@@ -14,6 +14,8 @@
 #ifndef SharedMemory_CONNECTION_H_
 #define SharedMemory_CONNECTION_H_
 
+#include <Manager/IndexRoot.h>
+#include <Manager/SlotReserve.h>
 #include <Manager/Transaction.h>
 #include <Entity/ImplMatcher.h>
 #include <cstdlib>
@@ -51,6 +53,8 @@ private:
     trid_t trid;                ///< オブジェクトが持つトランザクションID
     IsolationLevel level;    ///< アイソレーションレベル
     cursor_t  cursor_vct;       ///< カーソルオブジェクト配列(vector)
+    index_root_map_t index_roots;   ///< Tr内インデックスルート
+    slot_reserve_map_t slot_reserves;   ///< 挿入用の予約要素
 
 public:
     explicit Connection();
@@ -61,6 +65,10 @@ public:
             ::Entity::AbstIndexMatcher* = nullptr,
             const ::Entity::ImplMatcher* = nullptr,
             const ::Entity::ImplSorter*  = nullptr);
+    /// 逐次カーソルオープン
+    Cursor& openStreamCursor(::Entity::AppTable&, const bool,
+            ::Entity::AbstIndexMatcher* = nullptr,
+            const ::Entity::ImplMatcher* = nullptr);
     /// 挿入
     int executeInsert(::Entity::AppTable&);
     /// 更新
@@ -126,12 +134,14 @@ public:
     void getTransaction();
     /// トランザクション調整
     void adjustTransaction();
+    /// 逐次カーソルのクローズ
+    void closeStreamCursors();
     /// 現在時刻取得(msec)
     static msec_t msecGet();
     /// タイムアウトチェック
     static bool timeCheck(msec_t);
-
-    static void sleep();
+    /// 再試行待ち合わせ
+    static void wait(msec_t);
 };
 /*--------1---------2---------3---------4---------5---------6---------7------*/
 }  // namespace SharedMemory
@@ -14,6 +14,7 @@
 #include <Main/Connection.h>
 #include <Main/Cursor.h>
 #include <Manager/Entity.h>
+#include <Manager/IndexIterator.h>
 #include <string.h>
 
 #include <algorithm>
@@ -34,6 +35,7 @@ namespace SharedMemory
 *    ２    引数
 *            const char* table_name
 *            ::CApplicationData* app_data
+*            iterator : 逐次検索(逐次カーソルのみ)
 *
 *    ３    戻り値
 *            なし
@@ -42,8 +44,8 @@ namespace SharedMemory
 *            REV001 : 新規作成
 * </pre>
 **//**************************************************************************/
-Cursor::Cursor(::Entity::AppTable& data) : data(data), cursor_index(-1),
-        error_code(EXECUTE_OK) {
+Cursor::Cursor(::Entity::AppTable& data, IndexIterator* iterator) :
+        iterator(iterator), data(data), cursor_index(-1), error_code(EXECUTE_OK) {
     cursor.clear();
 }
 
@@ -76,6 +78,8 @@ Cursor::~Cursor() {
 *
 *    １    機能
 *            カーソル初期化時に作成されたカーソル配列に沿ってフェッチを実施する
+*            逐次カーソルはフェッチ毎にインデックスを次の一致タプルまで進め、
+*            更新ロックが取得できない場合はタイムアウトまで待ち合わせる
 *
 *    ２    引数
 *            なし
@@ -93,23 +97,42 @@ bool Cursor::fetch() {
     TRACE_LOG("Entity:" << data.getTableName());
 
     Entity& table = Entity::getAddr(data.getTableName());
+    ::Entity::rowid_t rowid;
 
-    // カーソルを進める
-    cursor_index++;
-    if(cursor_index < 0) ::std::out_of_range("Cursor Index");
-    // カーソルがvectorサイズを上回ったらフェッチ完了
-    if(static_cast<size_t>(cursor_index) >= cursor.size()) return false;
+    if(iterator != nullptr) {
+        // 逐次カーソルは次の一致タプルまで進める
+        rowid = EXECUTE_TIMEOUT;
+        for(msec_t start = Connection::msecGet(); Connection::timeCheck(start);
+                Connection::wait(start)) {
+            rowid = iterator->next();
+            if(rowid != EXECUTE_TIMEOUT) break;
+        }
+        if(rowid == EXECUTE_TIMEOUT) {
+            error_code = EXECUTE_TIMEOUT;
+            return false;
+        }
+        // 走査終了ならフェッチ完了
+        if(rowid == ::Entity::INVALID_ROWID) return false;
+        cursor_index++;
+    } else {
+        // カーソルを進める
+        cursor_index++;
+        if(cursor_index < 0) ::std::out_of_range("Cursor Index");
+        // カーソルがvectorサイズを上回ったらフェッチ完了
+        if(static_cast<size_t>(cursor_index) >= cursor.size()) return false;
+        rowid = cursor[cursor_index];
+    }
     // データがNULLの場合は内部利用(カーソルindex+1を返却)
     if(data.getTableSize() == 0) return true;
     // カーソル対象のデータ本体を取得
-    const ::Entity::AbstEntity& adr = table.getTuple(cursor[cursor_index]);
+    const ::Entity::AbstEntity& adr = table.getTuple(rowid);
 
     TRACE_LOG("cursor index:%ld adr:%p size:%lu", cursor_index, &adr, data.getTableSize());
 
     // データ本体をCApplicationDataにコピー
     data.setData(adr);
 
-    SHM_DEBUG_DMP(FETCH, table.getName().c_str(), cursor[cursor_index], &adr, data.getTableSize());
+    SHM_DEBUG_DMP(FETCH, table.getName().c_str(), rowid, &adr, data.getTableSize());
 
     // fetchできたことを返却(1)
     return true;
@@ -135,6 +158,8 @@ bool Cursor::fetch() {
 **//**************************************************************************/
 void Cursor::close() {
     cursor.clear();
+    delete iterator;
+    iterator = nullptr;
 }
 
 /*--------1---------2---------3---------4---------5---------6---------7------*/
@@ -22,6 +22,7 @@
 namespace SharedMemory
 {
 class Connection;
+class IndexIterator;
 /**************************************************************************//**
 *
 *     クラス名：共通メモリ管理機能カーソルクラス (CSMCursor)
@@ -37,12 +38,13 @@ class Connection;
 class Cursor {
 private:
     ::Entity::rowid_vec_t cursor;       ///< カーソル対象RowID vectoer
+    IndexIterator* iterator;            ///< 逐次検索(逐次カーソルのみ)
     ::Entity::AppTable& data;           ///< エンティティ
     long cursor_index;                  ///< カーソルINDEX
     int  error_code;                    ///< カーソルエラーコード
 
 public:
-    explicit Cursor(::Entity::AppTable&);
+    explicit Cursor(::Entity::AppTable&, IndexIterator* = nullptr);
     virtual ~Cursor();
 
     bool fetch();                           ///< フェッチ
@@ -55,6 +57,7 @@ public:
     *
     *    １    機能
     *           取得したカーソルに格納されているデータの数を返却する
+    *           逐次カーソルは件数が確定しないため0を返却する
     *
     *    ２    引数
     *           なし
@@ -93,6 +96,30 @@ public:
         return cursor;
     }
 
+    /**********************************************************************//**
+    *
+    *     関数名：逐次カーソル判定(isStream)
+    * <pre>
+    *
+    *    １    機能
+    *           逐次検索中の逐次カーソルかを返却する。
+    *           クローズ済みの逐次カーソルはfalseを返却する
+    *
+    *    ２    引数
+    *           なし
+    *
+    *    ３    戻り値
+    *           true  : 逐次検索中
+    *           false : それ以外
+    *
+    *    ４    履歴
+    *            REV001 : 新規作成
+    * </pre>
+    **//**********************************************************************/
+    inline bool isStream() const {
+        return iterator != nullptr;
+    }
+
     /**********************************************************************//**
     *
     *     関数名：カーソルエラーコード設定(setErrorCode)
@@ -0,0 +1,713 @@
+/**************************************************************************//**
+* @file
+*     モジュール名：共通メモリ管理機能 インクリメンタルGCクラス
+* <pre>
+*
+*    １  機能
+*          ガベージコレクションを上限付きのステップに分けて実行する
+*
+*    ２  関数名一覧
+*           コンストラクタ           (GarbageCollector)
+*           1ステップ実行            (step)
+*           1サイクル実行            (collect)
+*           1サイクル並列実行        (collect_parallel)
+*           常駐実行                 (run)
+*           サイクル開始             (begin_cycle)
+*           サイクル終了             (end_cycle)
+*           サイクル中断             (abort_cycle)
+*           サイクル所有判定         (owns_cycle)
+*           要素ブロック回収(ロック付き) (sweep_next)
+*           要素ブロック回収         (sweep_block)
+*           並列回収スレッド         (sweep_worker)
+*           回収件数ログ出力         (log_count)
+*           現在時刻取得             (usecGet)
+*
+*    ３  更新履歴
+*          REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+#include <Init/Initializer.h>
+#include <Main/GarbageCollector.h>
+#include <time.h>
+
+#include <algorithm>
+#include <thread>
+
+#include "inc/SHMmacro.h"
+
+namespace SharedMemory
+{
+using ::Entity::rowid_t;
+
+/**************************************************************************//**
+*
+*     関数名：コンストラクタ (GarbageCollector)
+* <pre>
+*
+*    １    機能
+*            1ステップの上限を指定してGCを作成する
+*
+*    ２    引数
+*            rows       : 1ステップの要素数上限(0は無制限)     [入力]
+*            usec       : 1ステップの時間上限(μs、0は無制限)  [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+GarbageCollector::GarbageCollector(size_t rows, uint64_t usec) :
+        step_rows(rows), step_usec(usec), collecting(false), cycle_seq(0),
+        coll_begin(0), coll_target(0), table_pos(0), opened(false), cursor(0),
+        sweep_end(0), skipped(0), count() {
+}
+
+/**************************************************************************//**
+*
+*     関数名：1ステップ実行 (step)
+* <pre>
+*
+*    １    機能
+*            サイクルの途中でなければ開始し、走査位置から要素数・時間の
+*            上限までBLOCK_SIZE件ずつ回収する。上限の判定はブロック毎に
+*            行うため、1ステップは上限を最大1ブロック分超える。
+*            エンティティは変更範囲を含むブロックのみ走査し、変更が
+*            なければ読み飛ばす。
+*            他のGCがサイクルを実行中なら何もせず、サイクルを他のGCに
+*            引き継がれていれば中断する
+*
+*    ２    引数
+*            なし
+*
+*    ３    戻り値
+*            true  : サイクルが完了した(trid_collectingを進めた)、
+*                    または他のGCが実行中
+*            false : サイクルの途中
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+bool GarbageCollector::step() {
+    if(!collecting && !begin_cycle()) return true;
+
+    const uint64_t deadline = step_usec != 0 ? usecGet() + step_usec : 0;
+    size_t rows = 0;
+    while(table_pos < tables.size()) {
+        // 引き継がれたサイクルは中断する(走査中の範囲は引継ぎ先が走査する)
+        if(!owns_cycle()) {
+            abort_cycle();
+            return true;
+        }
+        Entity& tbl = *tables[table_pos];
+        if(!opened) {
+            // 変更範囲をブロック境界に広げて取り出す
+            if(!tbl.take_dirty(coll_target, cycle_seq, cursor, sweep_end)) {
+                table_pos++;
+                skipped++;
+                continue;
+            }
+            const rowid_t block = static_cast<rowid_t>(Entity::BLOCK_SIZE);
+            cursor = cursor / block * block;
+            sweep_end = (sweep_end + block - 1) / block * block;
+            opened = true;
+        }
+
+        const rowid_t prev = cursor;
+        const bool done = sweep_next(tbl, cursor, sweep_end, count);
+        rows += static_cast<size_t>(cursor - prev);
+        if(done) {
+            tbl.done_dirty(cycle_seq);
+            log_count(tbl, count);
+            table_pos++;
+            opened = false;
+            cursor = 0;
+            count = Count();
+        }
+        if(step_rows != 0 && rows >= step_rows) return false;
+        if(deadline != 0 && usecGet() >= deadline) return false;
+    }
+    end_cycle();
+    return true;
+}
+
+/**************************************************************************//**
+*
+*     関数名：1サイクル実行 (collect)
+* <pre>
+*
+*    １    機能
+*            サイクルが完了するまでステップを繰り返す。
+*            ステップの間はエンティティのロックを保持しない
+*
+*    ２    引数
+*            なし
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void GarbageCollector::collect() {
+    while(!step()) { }
+}
+
+/**************************************************************************//**
+*
+*     関数名：1サイクル並列実行 (collect_parallel)
+* <pre>
+*
+*    １    機能
+*            各エンティティの変更範囲をPARALLEL_ROWS件毎の作業単位に分け、
+*            指定数のスレッドで並列に回収する。エンティティの排他ロックは
+*            プロセス内のスレッド間でも排他(Header::getLock)のため、同じ
+*            エンティティの作業単位はブロック毎に交互に進む。並列に進むのは
+*            異なるエンティティのみなので、作業単位はエンティティを順に
+*            巡る順序で取り出す。
+*            全スレッドの終了後にエンティティ毎の件数を出力し、
+*            trid_collectingを進める。
+*            途中のサイクルがあれば先に完了させる。他のGCがサイクルを
+*            実行中なら何もしない。いずれかのスレッドで例外が発生した
+*            場合、またはサイクルを引き継がれた場合は、trid_collectingを
+*            進めずにサイクルを中断する(走査中の範囲は次のサイクルが走査
+*            する)。例外は中断後に送出する
+*
+*    ２    引数
+*            workers    : スレッド数(1以下は単一スレッド)   [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void GarbageCollector::collect_parallel(size_t workers) {
+    if(collecting || workers <= 1) {
+        collect();
+        if(workers <= 1) return;
+    }
+    if(!begin_cycle()) return;
+
+    // エンティティ毎に作業単位に分割する
+    const rowid_t block = static_cast<rowid_t>(Entity::BLOCK_SIZE);
+    const rowid_t unit = static_cast<rowid_t>(PARALLEL_ROWS);
+    ::std::vector<::std::vector<Work>> perTable(tables.size());
+    size_t total = 0;
+    for(size_t i = 0; i < tables.size(); i++) {
+        rowid_t begin, end;
+        if(!tables[i]->take_dirty(coll_target, cycle_seq, begin, end)) {
+            skipped++;
+            continue;
+        }
+        begin = begin / block * block;
+        end = (end + block - 1) / block * block;
+        for(rowid_t pos = begin; pos < end; pos += unit)
+            perTable[i].push_back(Work{i, pos, ::std::min(pos + unit, end), Count()});
+        total += perTable[i].size();
+    }
+    // 同じエンティティのロックで待ち合わせないよう、エンティティを順に巡る
+    ::std::vector<Work> works;
+    works.reserve(total);
+    for(size_t n = 0; works.size() < total; n++) {
+        for(auto it = perTable.begin(); it != perTable.end(); it++)
+            if(n < it->size()) works.push_back((*it)[n]);
+    }
+
+    // 作業単位を並列に処理する
+    ::std::atomic<size_t> next(0);
+    ::std::atomic<bool> failed(false);
+    ::std::exception_ptr error;
+    ::std::vector<::std::thread> threads;
+    const size_t num = ::std::min(workers, works.size());
+    for(size_t i = 0; i < num; i++)
+        threads.push_back(::std::thread(&GarbageCollector::sweep_worker, this,
+                ::std::ref(works), ::std::ref(next), ::std::ref(failed),
+                ::std::ref(error)));
+    for(auto it = threads.begin(); it != threads.end(); it++) it->join();
+
+    if(failed.load()) {
+        abort_cycle();
+        ::std::rethrow_exception(error);
+    }
+    if(!owns_cycle()) {
+        abort_cycle();
+        return;
+    }
+    for(auto it = tables.begin(); it != tables.end(); it++) (*it)->done_dirty(cycle_seq);
+
+    // エンティティ毎に件数を集計して出力する
+    ::std::vector<Count> counts(tables.size(), Count());
+    for(auto it = works.begin(); it != works.end(); it++) {
+        Count& cnt = counts[it->table];
+        cnt.collected += it->count.collected;
+        cnt.remained += it->count.remained;
+        cnt.frozen += it->count.frozen;
+    }
+    for(size_t i = 0; i < tables.size(); i++)
+        if(!perTable[i].empty()) log_count(*tables[i], counts[i]);
+    table_pos = tables.size();
+    end_cycle();
+}
+
+/**************************************************************************//**
+*
+*     関数名：並列回収スレッド (sweep_worker)
+* <pre>
+*
+*    １    機能
+*            作業単位を順に取り出して回収する。処理済みの範囲は作業単位の
+*            先頭を進めて記録する。例外が発生した場合は最初の例外を記録し、
+*            全スレッドに中止を指示する。サイクルを引き継がれた場合は
+*            ブロック単位で中止する
+*
+*    ２    引数
+*            works      : 作業単位                      [入出力]
+*            next       : 次に取り出す作業単位          [入出力]
+*            failed     : 中止指示                      [入出力]
+*            error      : 最初に発生した例外            [出力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void GarbageCollector::sweep_worker(::std::vector<Work>& works,
+        ::std::atomic<size_t>& next, ::std::atomic<bool>& failed,
+        ::std::exception_ptr& error) {
+    for(size_t i = next++; i < works.size() && !failed.load(); i = next++) {
+        Work& work = works[i];
+        Entity& tbl = *tables[work.table];
+        try {
+            while(work.begin < work.end && !failed.load() && owns_cycle()) {
+                if(sweep_next(tbl, work.begin, work.end, work.count)) {
+                    work.begin = work.end;
+                    break;
+                }
+            }
+        } catch(...) {
+            bool expected = false;
+            if(failed.compare_exchange_strong(expected, true))
+                error = ::std::current_exception();
+            return;
+        }
+    }
+}
+
+/**************************************************************************//**
+*
+*     関数名：常駐実行 (run)
+* <pre>
+*
+*    １    機能
+*            停止指示があるまでステップを繰り返す。サイクルが完了する毎に
+*            GC要求(Transaction::requestGC)を指定時間まで待ち合わせる。
+*            専用スレッド・プロセスから呼び出す。実行中は常駐GCとして
+*            登録し、呼出し元でのしきい値超過時のGCを行わせない
+*
+*    ２    引数
+*            stop       : 停止指示                      [入力]
+*            interval   : サイクル間の休止時間(ms)      [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void GarbageCollector::run(const ::std::atomic<bool>& stop, msec_t interval) {
+    Transaction& trn = Transaction::getTrans();
+    trn.gc_workers.fetch_add(1);
+    try {
+        while(!stop.load()) {
+            if(step() && interval != 0) trn.waitGC(interval);
+        }
+    } catch(...) {
+        trn.gc_workers.fetch_sub(1);
+        throw;
+    }
+    trn.gc_workers.fetch_sub(1);
+}
+
+/**************************************************************************//**
+*
+*     関数名：サイクル開始 (begin_cycle)
+* <pre>
+*
+*    １    機能
+*            サイクルの所有を取得し、終了したプロセスの処理中Trをアボート
+*            (TRCCの公開後に終了したコミットはtrid_endを補完)し、回収された
+*            セッションの予約を空きに戻して、回収可能なTRIDの範囲とその範囲
+*            のTrのコミット有無を写し取る。範囲のTrは全て終了済みで状態は
+*            変わらないため、走査中はトランザクション管理情報を参照しない。
+*            所有者が生存していてCYCLE_TIMEOUT_USEC以内に進捗があれば
+*            サイクルを開始しない。それ以外は新しい通番で所有を引き継ぐ
+*
+*    ２    引数
+*            なし
+*
+*    ３    戻り値
+*            true  : サイクルを開始した
+*            false : 他のGCがサイクルを実行中
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+bool GarbageCollector::begin_cycle() {
+    Transaction& trn = Transaction::getTrans();
+
+    // 終了プロセスのセッションを回収する(セッション数分のみ確認)
+    trn.checkSessions();
+    const session_t self = trn.attachSession();
+    const uint64_t now = usecGet();
+    trn.getLock(Header::WRITE_LOCK);
+    // 所有者が生存していて進捗があれば任せる
+    const session_t owner = trn.gc_cycle_owner.load();
+    if(owner != SESSION_NONE && trn.isSessionAlive(owner)
+            && now < trn.gc_cycle_time.load() + CYCLE_TIMEOUT_USEC) {
+        trn.releaseLock();
+        return false;
+    }
+    if(owner != SESSION_NONE)
+        INFO_LOG("[GC] 停止したサイクルを引き継ぎます session:" << owner);
+    cycle_seq = trn.gc_cycle_seq.fetch_add(1) + 1;
+    trn.gc_cycle_owner.store(self);
+    trn.gc_cycle_time.store(now);
+    // プロセスの生存チェック
+    for(trid_t trid = trn.trid_collecting; trid < trn.trid_next; trid++) {
+        Transaction::Recode& tr = trn.getTransaction(trid);
+        // 管理情報の公開前は処理しない
+        if(tr.trid.load() != trid) continue;
+        const Transaction::Status status = tr.status;
+        if(status == Transaction::COMMITTED) {
+            // TRCCの公開後、trid_endの保存前に終了した場合は代わりに保存する
+            // (公開後のtrid_nextであれば、公開前に開始したTrは全てこれ未満となる)
+            if(tr.trid_end.load() != TRID_MAX
+                    || tr.trcc_end >= trn.trcc_next.load()
+                    || trn.isSessionAlive(tr.session)) continue;
+            trid_t expected = TRID_MAX;
+            tr.trid_end.compare_exchange_strong(expected, trn.trid_next.load());
+            continue;
+        }
+        // IN_PROGRESS以外は処理しない。
+        if(status != Transaction::IN_PROGRESS) continue;
+        // セッションが回収済みの場合、ステータスを変更する。
+        // コミット・ロールバックはロックを取らないため、処理中の場合のみ変更する
+        if(!trn.isSessionAlive(tr.session)) {
+            Transaction::Status expected = Transaction::IN_PROGRESS;
+            if(tr.status.compare_exchange_strong(expected, Transaction::ABORTED))
+                trn.notifyEnd(tr);
+        }
+    }
+    trn.releaseLock();
+    // ここまでのGC要求はこのサイクルで処理する
+    trn.gc_pending.store(0);
+
+    trn.getLock(Header::READ_LOCK);
+    // IN_PROGRESSのTRIDの下限を確認する
+    trid_t tridInProg = trn.trid_collecting;
+    for(trid_t next = trn.trid_next; tridInProg < next; tridInProg++) {
+        if(trn.getStatus(tridInProg) == Transaction::IN_PROGRESS) break;
+    }
+    // 回収可能なTRIDの範囲を確認し、コミット有無を写し取る
+    coll_begin = trn.trid_collecting;
+    committed.clear();
+    trid_t newTridColl = coll_begin;
+    const trcc_t published = trn.trcc_next.load(::std::memory_order_acquire);
+    for(trid_t next = trn.trid_next; newTridColl < next; newTridColl++) {
+        Transaction::Recode& tr = trn.getTransaction(newTridColl);
+        Transaction::Status status = trn.getStatus(newTridColl);
+        // trid_endの保存前(TRID_MAX)は、公開前のTRCCを読んだTrがありうる
+        if(status == Transaction::IN_PROGRESS
+                || (status == Transaction::COMMITTED && tridInProg < tr.trid_end.load()))
+                break; // IN_PROGRESSのTrから参照される可能性がある
+        // TRCCの公開前は、公開待ちの回収(recoverTicket)が参照する
+        if(status == Transaction::COMMITTED && tr.trcc_end >= published) break;
+        committed.push_back(status == Transaction::COMMITTED);
+    }
+    coll_target = newTridColl;
+    trn.releaseLock();
+
+    // 走査対象のエンティティを確定する
+    tables.clear();
+    for(auto it = Initializer::table_map.begin(); it != Initializer::table_map.end(); it++) {
+        if(nullptr == it->second) {
+            WARN_LOG("テーブル情報がnullです:" << it->first);
+            continue;
+        }
+        // 回収されたセッションの予約を空きに戻す(回収がなければ何もしない)
+        it->second->recover_reserved();
+        tables.push_back(it->second);
+    }
+    table_pos = 0;
+    opened = false;
+    cursor = 0;
+    skipped = 0;
+    count = Count();
+    collecting = true;
+    TRACE_LOG("[GC] cycle start : collecting=" << coll_begin << " target=" << coll_target);
+    return true;
+}
+
+/**************************************************************************//**
+*
+*     関数名：サイクル終了 (end_cycle)
+* <pre>
+*
+*    １    機能
+*            サイクルを所有していれば、trid_collectingを回収目標に進めて
+*            所有を解除し、トランザクション管理配列の空き待ちを起床する。
+*            引き継がれていれば進めない
+*
+*    ２    引数
+*            なし
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void GarbageCollector::end_cycle() {
+    Transaction& trn = Transaction::getTrans();
+    trn.getLock(Header::WRITE_LOCK);
+    const bool owned = trn.gc_cycle_seq.load() == cycle_seq;
+    if(owned) {
+        if(trn.trid_collecting < coll_target) trn.trid_collecting = coll_target;
+        trn.gc_cycle_owner.store(SESSION_NONE);
+    }
+    trn.releaseLock();
+    collecting = false;
+    if(!owned) {
+        INFO_LOG("[GC] サイクルが引き継がれたため回収範囲を進めません");
+        return;
+    }
+    // トランザクション管理配列の空き待ちを起床する
+    trn.notifyState();
+    TRACE_LOG("[GC] cycle end : collecting=" << coll_target << " skipped=" << skipped);
+}
+
+/**************************************************************************//**
+*
+*     関数名：サイクル中断 (abort_cycle)
+* <pre>
+*
+*    １    機能
+*            trid_collectingを進めずにサイクルを終える。サイクルを所有して
+*            いれば所有を解除する。取り出した変更範囲のうち走査が完了して
+*            いないものはエンティティに残り、次のサイクルが走査する
+*
+*    ２    引数
+*            なし
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void GarbageCollector::abort_cycle() {
+    Transaction& trn = Transaction::getTrans();
+    trn.getLock(Header::WRITE_LOCK);
+    if(trn.gc_cycle_seq.load() == cycle_seq) trn.gc_cycle_owner.store(SESSION_NONE);
+    trn.releaseLock();
+    collecting = false;
+    opened = false;
+    cursor = 0;
+    count = Count();
+    TRACE_LOG("[GC] cycle abort : collecting=" << coll_begin);
+}
+
+/**************************************************************************//**
+*
+*     関数名：サイクル所有判定 (owns_cycle)
+* <pre>
+*
+*    １    機能
+*            実行中のサイクルを他のGCに引き継がれていないか判定する。
+*            所有の確定はトランザクション管理情報の排他ロック中に行う
+*            (end_cycle)ため、ここでは走査の中断判定にのみ使う
+*
+*    ２    引数
+*            なし
+*
+*    ３    戻り値
+*            true  : 所有している
+*            false : 引き継がれた
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+bool GarbageCollector::owns_cycle() const {
+    return Transaction::getTrans().gc_cycle_seq.load() == cycle_seq;
+}
+
+/**************************************************************************//**
+*
+*     関数名：要素ブロック回収 (sweep_block)
+* <pre>
+*
+*    １    機能
+*            [begin,end)の要素のうち、回収範囲のアボート済みTrが作成した
+*            要素とコミット済みTrが削除した要素を開放し、アボート済みTrの
+*            削除・ロックを解除する。回収目標以上のTRIDが残る要素は変更範囲
+*            に登録し直し、予約中の要素は対象外とする。ブロック全体を走査
+*            した場合は全可視ブロックを設定する。エンティティ単位の排他
+*            ロック中に呼び出す
+*
+*    ２    引数
+*            tbl        : 対象エンティティ              [入力]
+*            begin      : 先頭の要素番号(ブロック境界)  [入力]
+*            end        : 終端の要素番号                [入力]
+*            cnt        : 回収件数                      [入出力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void GarbageCollector::sweep_block(Entity& tbl, rowid_t begin, rowid_t end,
+        Count& cnt) {
+    // 開放で使用中末尾が縮んだ場合はそこで終える
+    for(rowid_t rowid = begin; rowid < end && rowid < tbl.used_end; rowid++) {
+        Entity::Entry& ent = tbl.getEntry(rowid);
+        // 予約中の要素は予約範囲で回収する(recover_reserved)
+        if(ent.isReserved()) continue;
+        const trid_t xmin = ent.getXmin();
+        if(in_range(xmin) && !is_committed(xmin)) {
+            tbl.freeTuple(rowid);
+            cnt.collected++;
+            continue;
+        }
+        const trid_t xmax = ent.getXmax();
+        if(in_range(xmax)) {
+            if(is_committed(xmax)) {
+                tbl.freeTuple(rowid);
+                cnt.collected++;
+                continue;
+            }
+            ent.xmax = TRID_MAX;
+        }
+        if(in_range(ent.lock)) ent.lock = TRID_MAX;
+        // 次回以降のGCで処理するTRIDが残れば変更範囲に登録し直す
+        trid_t pending = ::std::min(ent.getXmin(), ent.getXmax());
+        if(ent.lock != TRID_MAX && ent.lock >= coll_target)
+            pending = ::std::min(pending, ent.lock);
+        if(pending != TRID_MAX && pending >= coll_target)
+            tbl.mark_dirty(pending, rowid);
+        cnt.remained++;
+    }
+    // 回収後の状態で全可視ブロックを設定する
+    if(end - begin == static_cast<rowid_t>(Entity::BLOCK_SIZE)
+            && tbl.mark_block_visible(coll_target, begin))
+        cnt.frozen++;
+}
+
+/**************************************************************************//**
+*
+*     関数名：要素ブロック回収(ロック付き) (sweep_next)
+* <pre>
+*
+*    １    機能
+*            エンティティの排他ロックを取得し、走査位置から1ブロックを
+*            回収して走査位置を進める
+*
+*    ２    引数
+*            tbl        : 対象エンティティ              [入力]
+*            pos        : 走査位置(ブロック境界)        [入出力]
+*            end        : 走査終端                      [入力]
+*            cnt        : 回収件数                      [入出力]
+*
+*    ３    戻り値
+*            true  : 走査終端(または使用中末尾)に達した
+*            false : 続きがある
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+bool GarbageCollector::sweep_next(Entity& tbl, rowid_t& pos, rowid_t end,
+        Count& cnt) {
+    tbl.getLock(Header::WRITE_LOCK);
+    const rowid_t limit = ::std::min(end, tbl.used_end);
+    const rowid_t last = ::std::min(
+            pos + static_cast<rowid_t>(Entity::BLOCK_SIZE), limit);
+    try {
+        sweep_block(tbl, pos, last, cnt);
+    } catch(...) {
+        tbl.releaseLock();
+        throw;
+    }
+    tbl.releaseLock();
+    // サイクルの進捗を記録する(他のGCに引き継がせない)
+    Transaction::getTrans().gc_cycle_time.store(usecGet());
+    if(last > pos) pos = last;
+    return pos >= limit;
+}
+
+/**************************************************************************//**
+*
+*     関数名：回収件数ログ出力 (log_count)
+* <pre>
+*
+*    １    機能
+*            エンティティ毎の回収件数をログに出力する
+*
+*    ２    引数
+*            tbl        : 対象エンティティ              [入力]
+*            cnt        : 回収件数                      [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void GarbageCollector::log_count(Entity& tbl, const Count& cnt) {
+    INFO_LOG("[GC] " << tbl.getName() << " : total=" << tbl.getMaxLine()
+            << " used_end=" << tbl.used_end << " free_begin=" << tbl.free_begin
+            << " collected=" << cnt.collected << " remained=" << cnt.remained
+            << " all_visible=" << cnt.frozen);
+}
+
+/**************************************************************************//**
+*
+*     関数名：現在時刻取得 (usecGet)
+* <pre>
+*
+*    １    機能
+*            単調増加時刻をμs単位で取得する
+*
+*    ２    引数
+*            なし
+*
+*    ３    戻り値
+*            現在時刻(μs)
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+uint64_t GarbageCollector::usecGet() {
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000uL
+            + static_cast<uint64_t>(ts.tv_nsec) / 1000uL;
+}
+
+/*--------1---------2---------3---------4---------5---------6---------7------*/
+}   // namespace SharedMemory
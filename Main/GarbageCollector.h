@@ -0,0 +1,167 @@
+/**************************************************************************//**
+* @file
+*     モジュール名：共通メモリ管理機能 インクリメンタルGCクラスヘッダ
+* <pre>
+*
+*    １  機能
+*          ガベージコレクションを小さな処理単位(ステップ)に分け、上限付き
+*          で少しずつ進めるインクリメンタルGCクラスを定義する
+*
+*    ２  更新履歴
+*          REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+#ifndef SharedMemory_GARBAGECOLLECTOR_H_
+#define SharedMemory_GARBAGECOLLECTOR_H_
+
+#include <Manager/Entity.h>
+#include <Manager/Header.h>
+#include <Manager/Transaction.h>
+
+#include <atomic>
+#include <exception>
+#include <vector>
+
+#include "inc/SHMConst.h"
+
+namespace SharedMemory
+{
+/**************************************************************************//**
+* クラス名 : インクリメンタルGCクラス(GarbageCollector)
+* <pre>
+*          1回のGC(サイクル)は、開始時に回収可能なTRIDの範囲
+*          [trid_collecting, 回収目標)と、その範囲のTrのコミット有無を写し
+*          取ってから、全エンティティを先頭から走査する。走査位置(テーブル・
+*          要素番号)を保持し、step()の呼出し毎に上限(要素数・経過時間)まで
+*          進める。エンティティの排他ロックはBLOCK_SIZE件毎に取り直すため、
+*          書込み側の待ちは1ブロック分に収まる。
+*          回収範囲のTrは開始時点で全て終了しており、以降その範囲のTRIDで
+*          書き込まれることはない。全エンティティの走査が終わった時点で
+*          trid_collectingを回収目標に進める。
+*          各エンティティは前回以降の変更範囲(Entity::take_dirty)のみを
+*          走査し、変更の最小TRIDが回収目標に届かなければ走査しない。
+*          回収目標以上のTRIDが残る要素は変更範囲に登録し直す。
+*          専用スレッド・プロセスからrun()で常駐させることもできる。
+*          collect_parallel()は変更範囲を作業単位(PARALLEL_ROWS件)に分け、
+*          複数スレッドで並列に回収してから、全スレッドの終了後に
+*          trid_collectingを進める。エンティティの排他ロックはスレッド間
+*          でも排他のため、並列に進むのは異なるエンティティの回収のみ。
+*          サイクルは全プロセスで1つとし、トランザクション管理情報の
+*          GCサイクル通番・実行中セッションで所有する。所有者が終了したか
+*          CYCLE_TIMEOUT_USECの間進捗がなければ、次のGCが引き継ぐ。
+*          引き継がれたGCは途中で中断し、trid_collectingを進めない。
+*          取り出した変更範囲は走査完了までエンティティに残るため、中断した
+*          サイクルの範囲は引継ぎ先が走査する
+* </pre>
+**//**************************************************************************/
+class GarbageCollector {
+public:
+    /// 1ステップの要素数上限の省略値
+    static const size_t DEFAULT_STEP_ROWS = 4096;
+    /// 並列回収の作業単位の要素数(BLOCK_SIZEの倍数)
+    static const size_t PARALLEL_ROWS = 65536;
+    /// サイクルを他のGCが引き継ぐまでの無進捗時間(μs)
+    static const uint64_t CYCLE_TIMEOUT_USEC = 1000000;
+
+private:
+    /*----1---------2---------3---------4---------5---------6---------7---*//**
+     * 構造体名 : 回収件数(Count)
+    **//*-1---------2---------3---------4---------5---------6---------7------*/
+    class Count {
+    public:
+        size_t collected;           ///< 回収数
+        size_t remained;            ///< 残存数
+        size_t frozen;              ///< 全可視ブロック数
+    };
+
+    /*----1---------2---------3---------4---------5---------6---------7---*//**
+     * 構造体名 : 並列回収の作業単位(Work)
+    **//*-1---------2---------3---------4---------5---------6---------7------*/
+    class Work {
+    public:
+        size_t            table;    ///< 対象エンティティ(tablesの位置)
+        ::Entity::rowid_t begin;    ///< 先頭の要素番号(ブロック境界)
+        ::Entity::rowid_t end;      ///< 終端の要素番号
+        Count             count;    ///< 回収件数
+    };
+
+    size_t   step_rows;                 ///< 1ステップの要素数上限(0は無制限)
+    uint64_t step_usec;                 ///< 1ステップの時間上限(μs、0は無制限)
+    bool     collecting;                ///< サイクル実行中
+    uint64_t cycle_seq;                 ///< 所有するGCサイクル通番
+    trid_t   coll_begin;                ///< サイクル開始時のtrid_collecting
+    trid_t   coll_target;               ///< 回収目標(これ未満を回収する)
+    ::std::vector<bool> committed;      ///< [coll_begin,coll_target)のコミット有無
+    ::std::vector<Entity*> tables;      ///< 走査対象のエンティティ
+    size_t   table_pos;                 ///< 走査中のエンティティ
+    bool     opened;                    ///< 走査中のエンティティの変更範囲取出し済み
+    ::Entity::rowid_t cursor;           ///< 走査中の要素番号
+    ::Entity::rowid_t sweep_end;        ///< 走査中のエンティティの走査終端
+    size_t   skipped;                   ///< 変更なしで走査しなかったエンティティ数
+    Count    count;                     ///< 走査中のエンティティの回収件数
+
+public:
+    explicit GarbageCollector(size_t = DEFAULT_STEP_ROWS, uint64_t = 0);
+    virtual ~GarbageCollector() { }
+
+    /**********************************************************************//**
+    *   関数名 : 上限設定(setBudget)
+    *   引数   : rows : 1ステップの要素数上限(0は無制限)        [入力]
+    *            usec : 1ステップの時間上限(μs、0は無制限)     [入力]
+    *   戻り値 : なし
+    **//*********************************************************************/
+    inline void setBudget(size_t rows, uint64_t usec) {
+        step_rows = rows;
+        step_usec = usec;
+    }
+
+    /**********************************************************************//**
+    *   関数名 : サイクル実行中判定(isCollecting)
+    *   引数   : なし
+    *   戻り値 : true : サイクルの途中
+    **//*********************************************************************/
+    inline bool isCollecting() const { return collecting; }
+
+    /// 1ステップ実行
+    bool step();
+    /// 1サイクル実行
+    void collect();
+    /// 1サイクル並列実行
+    void collect_parallel(size_t);
+    /// 常駐実行
+    void run(const ::std::atomic<bool>&, msec_t);
+
+private:
+    /// サイクル開始
+    bool begin_cycle();
+    /// サイクル終了
+    void end_cycle();
+    /// サイクル中断
+    void abort_cycle();
+    /// サイクル所有判定
+    bool owns_cycle() const;
+    /// 要素ブロック回収(ロック付き)
+    bool sweep_next(Entity&, ::Entity::rowid_t&, ::Entity::rowid_t, Count&);
+    /// 要素ブロック回収
+    void sweep_block(Entity&, ::Entity::rowid_t, ::Entity::rowid_t, Count&);
+    /// 並列回収スレッド
+    void sweep_worker(::std::vector<Work>&, ::std::atomic<size_t>&,
+            ::std::atomic<bool>&, ::std::exception_ptr&);
+    /// 回収件数ログ出力
+    static void log_count(Entity&, const Count&);
+    /// 回収範囲のコミット判定
+    inline bool is_committed(trid_t trid) const {
+        return committed[static_cast<size_t>(trid - coll_begin)];
+    }
+    /// 回収範囲判定
+    inline bool in_range(trid_t trid) const {
+        return coll_begin <= trid && trid < coll_target;
+    }
+    /// 現在時刻取得(μs)
+    static uint64_t usecGet();
+};
+
+/*--------1---------2---------3---------4---------5---------6---------7------*/
+}  // end namespace SharedMemory
+
+#endif // SharedMemory_GARBAGECOLLECTOR_H_
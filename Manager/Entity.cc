@@ -15,9 +15,13 @@
 #include <Init/Initializer.h>
 #include <Main/Access.h>
 #include <Manager/Entity.h>
+#include <Manager/IndexManager.h>
+#include <Manager/Snapshot.h>
 #include <Manager/Transaction.h>
 #include <string.h>
 
+#include <algorithm>
+#include <limits>
 #include <string>
 
 #include "inc/SHMConst.h"
@@ -27,7 +31,25 @@ namespace SharedMemory
 {
 using ::std::string;
 using ::Entity::rowid_t;
+using ::Entity::INVALID_ROWID;
+using ::Entity::rowid_vec_t;
 using ::Entity::AbstEntity;
+
+namespace {
+/// 変更範囲が空の場合の先頭
+const rowid_t DIRTY_NONE = ::std::numeric_limits<rowid_t>::max();
+
+/// 値が小さい場合のみ更新する(既に小さければ書き込まない)
+template<typename T> void atomic_min(::std::atomic<T>& word, T v) {
+    T cur = word.load(::std::memory_order_relaxed);
+    while(v < cur && !word.compare_exchange_weak(cur, v)) { }
+}
+/// 値が大きい場合のみ更新する(既に大きければ書き込まない)
+template<typename T> void atomic_max(::std::atomic<T>& word, T v) {
+    T cur = word.load(::std::memory_order_relaxed);
+    while(cur < v && !word.compare_exchange_weak(cur, v)) { }
+}
+}  // namespace
 /**************************************************************************//**
 *
 *     関数名：個別エンティティ情報アドレス取得 (getAddr)
@@ -58,10 +80,12 @@ Entity& Entity::getAddr(const string& name) {
 }
 
 void Entity::checkRowID(rowid_t rowid) {
-    if(rowid < 0 || rowid > used_end || rowid >= static_cast<rowid_t>(getMaxLine()))
+    if(rowid < 0 || rowid > used_end || rowid >= init_end
+            || rowid >= static_cast<rowid_t>(getMaxLine()))
         OUT_OF_RANGE("RowIDが管理サイズを超えています:"
                 "(Entity=" << getName() << " RowID=" << rowid <<
-                " UsedEnd=" << used_end << " MaxLine="<< getMaxLine()<< ")");
+                " UsedEnd=" << used_end << " InitEnd=" << init_end <<
+                " MaxLine="<< getMaxLine()<< ")");
 }
 
 /**************************************************************************//**
@@ -84,7 +108,7 @@ void Entity::checkRowID(rowid_t rowid) {
 **//**************************************************************************/
 Entity::Entry& Entity::getEntry(rowid_t rowid) {
     checkRowID(rowid);
-    return tag_entries[rowid];
+    return entryAt(rowid);
 }
 
 /**************************************************************************//**
@@ -107,15 +131,12 @@ Entity::Entry& Entity::getEntry(rowid_t rowid) {
 **//**************************************************************************/
 AbstEntity& Entity::getTuple(rowid_t rowid) {
     checkRowID(rowid);
-    return *reinterpret_cast<AbstEntity*>(reinterpret_cast<size_t>(
-            &tag_entries[getMaxLine()]) + (getUnitSize() * rowid));
+    return *reinterpret_cast<AbstEntity*>(tupleAt(rowid));
 }
 
 void Entity::setTuple(rowid_t rowid, const AbstEntity& ent) {
     checkRowID(rowid);
-    ::memcpy(reinterpret_cast<void*>(reinterpret_cast<size_t>(
-            &tag_entries[getMaxLine()]) + (getUnitSize() * rowid)),
-            &ent, getUnitSize());
+    ::memcpy(reinterpret_cast<void*>(tupleAt(rowid)), &ent, getUnitSize());
 }
 /**************************************************************************//**
 *
@@ -123,12 +144,19 @@ void Entity::setTuple(rowid_t rowid, const AbstEntity& ent) {
 * <pre>
 *
 *    １    機能
-*            個別管理領域を初期化する
+*            個別管理領域を初期化する。
+*            領域はゼロクリアされていること(createMemoryで作成直後)。
+*            要素エントリ・全可視マップ・空きマップはここでは書き込まず、
+*            要素エントリは割当て時にinit_slotsで少しずつ初期化する。
+*            init_end以降の要素は暗黙の空きとして扱い、ページは初めて
+*            使う時にフォールトする
 *
 *    ２    引数
 *            name      :    領域名                 [入力]
 *            num       :    フィールド数(LINE)     [入力]
 *            unit_size :    データサイズ(byte)     [入力]
+*            reserve   :    確保済み要素数(省略時はnum) [入力]
+*            type      :    物理配置種別           [入力]
 *
 *    ３    戻り値
 *            なし
@@ -137,15 +165,93 @@ void Entity::setTuple(rowid_t rowid, const AbstEntity& ent) {
 *            REV001 : 新規作成
 * </pre>
 **//**************************************************************************/
-void Entity::init(const string& name, const rowid_t num, const size_t size) {
-    Header::init(name, 0, num, getSize(num, size), size);
+void Entity::init(const string& name, const rowid_t num, const size_t size,
+        const size_t reserve, const LayoutType type) {
+    const size_t rsv = ::std::max(reserve, static_cast<size_t>(num));
+    layout = getLayout(rsv, size, type);
+    Header::init(name, 0, num, layout.size, size);
     tuple_size = size;
+    reserve_line = rsv;
     free_begin = 0;
-    // 対象全フィールドのxminを無効に更新する
-    used_end = num;
-    for(rowid_t rowid = 0; rowid < num; rowid++)
-        getEntry(rowid).xmin = TRID_MAX;
+    index_type = INDEX_TREAP;
     used_end = 0;
+    // 全可視マップ・空きマップはゼロ(未設定・空きなし)のまま
+    init_end = 0;
+    dirty_trid.store(TRID_MAX);
+    dirty_begin.store(DIRTY_NONE);
+    dirty_end.store(0);
+    sweep_seq = 0;
+    sweep_begin = DIRTY_NONE;
+    sweep_end = 0;
+    used_num = 0;
+    reserved_num.store(0);
+    reserve_begin = DIRTY_NONE;
+    reserve_end = 0;
+    reserve_checked.store(0);
+    gc_threshold = 0;
+}
+
+/**************************************************************************//**
+*
+*     関数名：要素エントリ初期化 (init_slots)
+* <pre>
+*
+*    １    機能
+*            init_endから指定位置までの要素エントリを空きに初期化し、
+*            空きマップに登録する。
+*            エンティティ単位の排他ロック中、または初期化中に呼び出すこと
+*
+*    ２    引数
+*            end       :    初期化する終端位置(MaxLine以下) [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void Entity::init_slots(rowid_t end) {
+    if(end > static_cast<rowid_t>(getMaxLine())) OUT_OF_RANGE("end");
+    for(rowid_t rowid = init_end; rowid < end; rowid++) {
+        Entry& ent = entryAt(rowid);
+        ent.xmin = TRID_MAX;
+        ent.xmax = TRID_MAX;
+        ent.lock = TRID_MAX;
+        mark_free_slot(rowid);
+    }
+    if(init_end < end) init_end = end;
+}
+
+/**************************************************************************//**
+*
+*     関数名：空き要素エントリ取得 (next_free_slot)
+* <pre>
+*
+*    １    機能
+*            空きマップから先頭の空き要素を取得する。空きがなければ
+*            未初期化の要素をBLOCK_SIZE件初期化し、未初期化の要素も
+*            なければ確保済みの範囲で要素数を拡張してから取得する。
+*            エンティティ単位の排他ロック中に呼び出すこと
+*
+*    ２    引数
+*            なし
+*
+*    ３    戻り値
+*            空きの要素番号。空きがなければINVALID_ROWID
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+rowid_t Entity::next_free_slot() {
+    const rowid_t ret = find_free_slot();
+    if(ret != INVALID_ROWID) return ret;
+    if(init_end >= static_cast<rowid_t>(getMaxLine()) && !expand())
+        return INVALID_ROWID;
+    init_slots(::std::min(init_end + static_cast<rowid_t>(BLOCK_SIZE),
+            static_cast<rowid_t>(getMaxLine())));
+    return find_free_slot();
 }
 
 /**************************************************************************//**
@@ -170,13 +276,86 @@ void Entity::init(const string& name, const rowid_t num, const size_t size) {
 **//**************************************************************************/
 bool Entity::check_tuple_readable(trid_t trid, Entry& ent) {
     // xmin取得
-    trid_t xmin = Transaction::is_tr_valid_to_read(trid, ent.xmin) ? ent.xmin : TRID_MAX;
+    trid_t xmin = get_visible_trid(trid, ent.xmin, ent.xmin_cc);
+    if(xmin == TRID_MAX) return false;
     // xmax取得
-    trid_t xmax = Transaction::is_tr_valid_to_read(trid, ent.xmax) ? ent.xmax : TRID_MAX;
+    trid_t xmax = get_visible_trid(trid, ent.xmax, ent.xmax_cc);
     // xmaxとxminの関係から読込み可能かを判定する
     return xmin <= trid && trid < xmax;
 }
 
+/**************************************************************************//**
+*
+*     関数名：ヒントビットによる可視TRID取得 (get_visible_trid)
+* <pre>
+*
+*    １    機能
+*            xmin/xmaxのTRIDが自Trから可視なら、そのTRIDを返す。
+*            ヒントビットがあればトランザクション管理情報を参照せずに
+*            判定し、なければ判定後に確定した状態をヒントビットに記録する。
+*            ヒントビットはTRIDと同じワードにCASで設定するため、TRIDが
+*            書き換えられた場合は記録されない。コミットTRCCは記録中の印を
+*            CASで設定したプロセスのみが書き、書いた後にコミット済みとする。
+*            スレッドに自Trのスナップショットが有効ならそれで判定する
+*
+*    ２    引数
+*            self_trid  :    自トランザクションID          [入力]
+*            word       :    xmin/xmax                     [入出力]
+*            cc         :    コミットTRCC(下位32ビット)    [入出力]
+*
+*    ３    戻り値
+*            可視ならTRID、不可視ならTRID_MAX
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+trid_t Entity::get_visible_trid(trid_t trid, ::std::atomic<trid_t>& word,
+        uint32_t& cc) {
+    trid_t raw = word.load(::std::memory_order_acquire);
+    if(raw == TRID_MAX) return TRID_MAX;
+    trid_t tgt = Entry::strip(raw);
+
+    // 文のスナップショットがあれば共有メモリの管理情報は参照しない
+    const Snapshot* snap = Snapshot::getCurrent(trid);
+
+    // 他プロセスがコミットTRCCを記録中ならヒントなしとして判定する
+    const bool busy = (raw & Entry::HINT_MASK) == Entry::HINT_BUSY;
+    // アボート済みなら不可視
+    if(!busy && (raw & Entry::HINT_ABORTED)) return TRID_MAX;
+    // コミット済みならTRCCのみで判定
+    if(!busy && (raw & Entry::HINT_COMMITTED)) {
+        bool visible = snap != nullptr ? snap->is_trcc_visible(tgt, cc) :
+                Transaction::is_trcc_visible(trid, tgt, cc);
+        return visible ? tgt : TRID_MAX;
+    }
+
+    Transaction::Status status;
+    trcc_t trccEnd;
+    bool ret = snap != nullptr ?
+            snap->is_tr_valid_to_read(tgt, &status, &trccEnd) :
+            Transaction::is_tr_valid_to_read(trid, tgt, &status, &trccEnd);
+    // 確定した状態をヒントビットに記録する(記録中は他から記録しない)
+    if(busy) {
+        // 記録中のプロセスに任せる
+    } else if(status == Transaction::COMMITTED) {
+        // 記録中の印をCASで設定できた場合のみTRCCを書き、コミット済みにする
+        // (TRIDが書き換えられていればTRCCは書かない)
+        trid_t busyRaw = raw | Entry::HINT_BUSY;
+        if(word.compare_exchange_strong(raw, busyRaw, ::std::memory_order_acquire,
+                ::std::memory_order_relaxed)) {
+            cc = static_cast<uint32_t>(trccEnd);
+            word.compare_exchange_strong(busyRaw, Entry::strip(busyRaw)
+                    | Entry::HINT_COMMITTED, ::std::memory_order_release,
+                    ::std::memory_order_relaxed);
+        }
+    } else if(status == Transaction::ABORTED) {
+        word.compare_exchange_strong(raw, raw | Entry::HINT_ABORTED,
+                ::std::memory_order_release, ::std::memory_order_relaxed);
+    }
+    return ret ? tgt : TRID_MAX;
+}
+
 /**************************************************************************//**
 *
 *     関数名：要素書込可否チェック (check_tuple_writable)
@@ -201,15 +380,17 @@ bool Entity::check_tuple_readable(trid_t trid, Entry& ent) {
 Entity::Status Entity::check_tuple_writable(trid_t trid, Entry& ent) {
     if(trid == TRID_MAX) return LOCKED;
     // xmax取得
-    trid_t xmax = Transaction::is_tr_valid_to_write(trid,
-        ent.xmax, Transaction::IS_XMAX) ? ent.xmax : TRID_MAX;
+    trid_t xmax = ent.getXmax();
+    if(!Transaction::is_tr_valid_to_write(trid, xmax, Transaction::IS_XMAX))
+        xmax = TRID_MAX;
     // lock取得
     trid_t lock = Transaction::is_tr_valid_to_write(trid,
         ent.lock, Transaction::IS_LOCK) ? ent.lock : TRID_MAX;
     // xmax/lockともに無効なら書込み可能
     if(xmax == TRID_MAX && lock == TRID_MAX)
-        return ent.xmin == trid ? WRITEABLE : INSERTABLE;
-    // それ以外は書込み禁止
+        return ent.getXmin() == trid ? WRITEABLE : INSERTABLE;
+    // それ以外は書込み禁止、処理中のTrが原因なら終了を待ち合わせる
+    Transaction::setBlocker(lock != TRID_MAX ? lock : xmax);
     return LOCKED;
 }
 
@@ -233,28 +414,244 @@ Entity::Status Entity::check_tuple_writable(trid_t trid, Entry& ent) {
 * </pre>
 **//**************************************************************************/
 rowid_t Entity::createTuple(trid_t trid) {
-    rowid_t ret = EXECUTE_FULL;
     if(trid == TRID_MAX) OUT_OF_RANGE("trid");
-    // 空き領域の先頭からMaxLineまで検索
-    for(rowid_t rowid = free_begin;
-            rowid < static_cast<rowid_t>(getMaxLine()); rowid++) {
-        // エントリが空きならそのエントリを使う
+    // 空きマップから先頭の空きエントリを取得(必要に応じて初期化・拡張)
+    rowid_t ret = next_free_slot();
+    if(ret == INVALID_ROWID) MEMORYFULL("メモリフル:" << getName());
+
+    Entry& ent = entryAt(ret);
+    mark_used_slot(ret);
+    if(used_end < ret + 1) used_end = ret + 1;
+    clear_all_visible(ret);
+    mark_dirty(trid, ret);
+    ent.xmin = trid;
+    ent.xmax = TRID_MAX;
+    ent.lock = TRID_MAX;
+    // 最新の空きエントリを設定
+    free_begin = find_free_slot();
+    if(free_begin == INVALID_ROWID) free_begin = init_end;
+    // 使用率がしきい値を超えたらGCを要求する
+    if(gc_threshold != 0 && getFillPercent() >= gc_threshold)
+        Transaction::getTrans().requestGC();
+
+    return ret;
+}
+
+/**************************************************************************//**
+*
+*     関数名：要素数拡張 (expand)
+* <pre>
+*
+*    １    機能
+*            確保済み要素数(ReserveLine)を上限に、要素数(MaxLine)を倍に
+*            拡張する。配置は確保済み要素数で決まっているため、要素本体の
+*            移動や再マップは行わず、参照中のプロセスも止めない。
+*            拡張分の要素エントリは未初期化(暗黙の空き)のままとし、
+*            割当て時にinit_slotsで初期化する。ハッシュインデックスはスロット位置が
+*            MaxLineに依存するため拡張しない。
+*            エンティティ単位の排他ロック中に呼び出すこと
+*
+*    ２    引数
+*            なし
+*
+*    ３    戻り値
+*            true  : 拡張した
+*            false : 拡張できない(上限到達)
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+bool Entity::expand() {
+    if(index_type == INDEX_HASH) return false;
+    const size_t oldMax = getMaxLine();
+    const size_t newMax = ::std::min(reserve_line, ::std::max(oldMax * 2, oldMax + 1));
+    if(newMax <= oldMax) return false;
+
+    setMaxLine(newMax);
+
+    INFO_LOG("[EXPAND] " << getName() << " : MaxLine " << oldMax << " -> "
+            << newMax << " (ReserveLine=" << reserve_line << ")");
+    return true;
+}
+
+/**************************************************************************//**
+*
+*     関数名：要素エントリ予約 (reserveTuples)
+* <pre>
+*
+*    １    機能
+*            空き要素エントリをまとめて自プロセスで予約する。
+*            予約した要素は空きマップから外し、lockに予約印を記録する。
+*            xminは空き(TRID_MAX)のままなので検索からは不可視となる。
+*            予約中の要素は変更範囲ではなく予約範囲に登録し、GCは予約した
+*            セッションが回収された場合のみ走査する(recover_reserved)。
+*            エンティティ単位の排他ロックは本関数内で取得する
+*
+*    ２    引数
+*            rows       : 予約した要素番号の格納先      [出力]
+*            num        : 予約する要素数                [入力]
+*
+*    ３    戻り値
+*            予約した要素数。空きがなければ0
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+size_t Entity::reserveTuples(rowid_vec_t& rows, size_t num) {
+    const trid_t mark = Entry::reserveMark(Transaction::getTrans().attachSession());
+    size_t ret = 0;
+
+    // エンティティ単位で排他ロック
+    getLock(Header::WRITE_LOCK);
+    // 予約中の要素がなければ予約範囲を空にする
+    if(reserved_num.load() == 0) {
+        reserve_begin = DIRTY_NONE;
+        reserve_end = 0;
+    }
+    for(; ret < num; ret++) {
+        const rowid_t rowid = next_free_slot();
+        if(rowid == INVALID_ROWID) break;
+        Entry& ent = entryAt(rowid);
+        mark_used_slot(rowid);
+        // 予約中の要素は使用中末尾の範囲に含める
+        if(used_end < rowid + 1) used_end = rowid + 1;
+        ent.xmax = TRID_MAX;
+        ent.lock = mark;
+        // 予約したプロセスの終了に備え、予約範囲に登録する
+        if(rowid < reserve_begin) reserve_begin = rowid;
+        if(reserve_end < rowid + 1) reserve_end = rowid + 1;
+        reserved_num.fetch_add(1);
+        rows.push_back(rowid);
+    }
+    free_begin = find_free_slot();
+    if(free_begin == INVALID_ROWID) free_begin = init_end;
+    // 使用率がしきい値を超えたらGCを要求する
+    if(gc_threshold != 0 && getFillPercent() >= gc_threshold)
+        Transaction::getTrans().requestGC();
+    releaseLock();
+    return ret;
+}
+
+/**************************************************************************//**
+*
+*     関数名：予約要素エントリ作成 (claimTuple)
+* <pre>
+*
+*    １    機能
+*            自プロセスで予約した要素エントリを自Trで作成する。
+*            予約した要素は他から割り当てられないため排他ロックは不要。
+*            xminを先に設定し、予約印を消す間も使用中末尾の範囲に残す
+*
+*    ２    引数
+*            self_trid  : 自トランザクションID          [入力]
+*            rowid      : 予約した要素番号              [入力]
+*
+*    ３    戻り値
+*            作成した要素番号
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+rowid_t Entity::claimTuple(trid_t trid, rowid_t rowid) {
+    if(trid == TRID_MAX) OUT_OF_RANGE("trid");
+    Entry& ent = getEntry(rowid);
+    if(!ent.isReserved())
+        INVALID_ARGUMENT("予約されていない要素です:" << getName()
+                << " RowID=" << rowid);
+    clear_all_visible(rowid);
+    mark_dirty(trid, rowid);
+    ent.xmin = trid;
+    ent.lock = TRID_MAX;
+    reserved_num.fetch_sub(1);
+    return rowid;
+}
+
+/**************************************************************************//**
+*
+*     関数名：要素エントリ予約解除 (releaseTuples)
+* <pre>
+*
+*    １    機能
+*            未使用の予約要素エントリを空きに戻す。
+*            エンティティ単位の排他ロックは本関数内で取得する
+*
+*    ２    引数
+*            rows       : 予約した要素番号              [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void Entity::releaseTuples(const rowid_vec_t& rows) {
+    // エンティティ単位で排他ロック
+    getLock(Header::WRITE_LOCK);
+    for(auto it = rows.begin(); it != rows.end(); it++) {
+        Entry& ent = entryAt(*it);
+        if(!ent.isReserved()) continue;
+        ent.lock = TRID_MAX;
+        freeTuple(*it);
+        reserved_num.fetch_sub(1);
+    }
+    releaseLock();
+}
+
+/**************************************************************************//**
+*
+*     関数名：終了プロセスの予約回収 (recover_reserved)
+* <pre>
+*
+*    １    機能
+*            前回の確認以降にセッションが回収されていれば、予約範囲の
+*            予約中の要素エントリのうち、予約したセッションが解除・回収
+*            済みのものを空きに戻し、予約範囲を残りの予約に縮める。
+*            予約がない、またはセッションの回収がなければロックを取らない。
+*            エンティティ単位の排他ロックは本関数内で取得する
+*
+*    ２    引数
+*            なし
+*
+*    ３    戻り値
+*            回収した要素数
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+size_t Entity::recover_reserved() {
+    Transaction& trn = Transaction::getTrans();
+    const uint64_t reclaimed = trn.session_reclaimed.load();
+    if(reserved_num.load() == 0 || reserve_checked.load() == reclaimed) return 0;
+
+    size_t ret = 0;
+    // エンティティ単位で排他ロック
+    getLock(Header::WRITE_LOCK);
+    rowid_t begin = DIRTY_NONE;
+    rowid_t end = 0;
+    const rowid_t last = ::std::min(reserve_end, used_end);
+    for(rowid_t rowid = reserve_begin; rowid < last; rowid++) {
         Entry& ent = getEntry(rowid);
-        if(ent.xmin == TRID_MAX) {
-            if(used_end < rowid + 1) used_end = rowid + 1;
-            ent.xmin = trid;
-            ent.xmax = TRID_MAX;
-            ent.lock = TRID_MAX;
-            ret = rowid;
-            break;
+        if(!ent.isReserved()) continue;
+        if(trn.isSessionAlive(ent.getReservedSession())) {
+            if(rowid < begin) begin = rowid;
+            end = rowid + 1;
+            continue;
         }
+        ent.lock = TRID_MAX;
+        freeTuple(rowid);
+        reserved_num.fetch_sub(1);
+        ret++;
     }
-    if(ret == EXECUTE_FULL) MEMORYFULL("メモリフル:" << getName());
-    // 空きエントリの先頭を移動して最新の空きエントリを設定
-    for(; free_begin < (rowid_t)this->getMaxLine(); free_begin++)
-        if(getEntry(free_begin).xmin == TRID_MAX)
-            break;
-
+    reserve_begin = begin;
+    reserve_end = end;
+    reserve_checked.store(reclaimed);
+    releaseLock();
+    if(ret != 0) WARN_LOG("終了プロセスの予約を回収しました " << getName() << ":" << ret);
     return ret;
 }
 
@@ -304,6 +701,8 @@ rowid_t Entity::updateTuple(trid_t trid, rowid_t rowid) {
             // 元のエントリから新しいエントリへメモリコピー
             setTuple(newRowID, getTuple(rowid));
             // 古いエントリの無効化
+            clear_all_visible(rowid);
+            mark_dirty(trid, rowid);
             ent.xmax = trid;
         }
         break;
@@ -360,6 +759,8 @@ int Entity::deleteTuple(trid_t trid, rowid_t rowid) {
         break;
     case INSERTABLE:
         // エントリの無効化
+        clear_all_visible(rowid);
+        mark_dirty(trid, rowid);
         ent.xmax = trid;
         ret = EXECUTE_OK;
         break;
@@ -400,14 +801,355 @@ void Entity::freeTuple(rowid_t rowid) {
                 "(RowID=" <<rowid << " MaxLine="<< getMaxLine() << ")");
     }
 
+    // インデックス管理情報は版の連結から外す
+    if(this == Initializer::index_addr)
+        static_cast<IndexManager*>(this)->unlink_root(rowid);
     // 空き領域調整
     if(rowid < free_begin) free_begin = rowid;
     // xmin無効化
+    clear_all_visible(rowid);
     getEntry(rowid).xmin = TRID_MAX;
-    // 使用中末尾調整
-    for(; used_end > 0; used_end--)
-        if(getEntry(used_end - 1).xmin != TRID_MAX)
+    mark_free_slot(rowid);
+    if(used_num > 0) used_num--;
+    // 使用中末尾調整(予約中の要素は使用中とみなす)
+    for(; used_end > 0; used_end--) {
+        const Entry& ent = getEntry(used_end - 1);
+        if(ent.xmin != TRID_MAX || ent.isReserved())
             break;
+    }
+}
+
+/**************************************************************************//**
+*
+*     関数名：要素可視判定 (check_row_readable)
+* <pre>
+*
+*    １    機能
+*            全可視ブロックの要素はMVCC判定を省略して可視とする。
+*            それ以外はcheck_tuple_readableで判定する
+*
+*    ２    引数
+*            self_trid  : 自トランザクションID          [入力]
+*            rowid      : 要素番号                      [入力]
+*
+*    ３    戻り値
+*            true  : 可視
+*            false : 不可視
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+bool Entity::check_row_readable(trid_t trid, rowid_t rowid) {
+    Entry& ent = getEntry(rowid);
+    if(is_all_visible(rowid)) return true;
+    return check_tuple_readable(trid, ent);
+}
+
+/**************************************************************************//**
+*
+*     関数名：全可視ブロック判定 (is_all_visible)
+* <pre>
+*
+*    １    機能
+*            要素を含むブロックが全可視(全要素が使用中で、全Trから可視)か
+*            を全可視マップから判定する
+*
+*    ２    引数
+*            rowid      : 要素番号                      [入力]
+*
+*    ３    戻り値
+*            true  : 全可視
+*            false : 未確定
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+bool Entity::is_all_visible(rowid_t rowid) {
+    const size_t block = static_cast<size_t>(rowid) / BLOCK_SIZE;
+    return (getVisibleMap()[block / 64].load(::std::memory_order_acquire)
+            >> (block % 64)) & 1;
+}
+
+/**************************************************************************//**
+*
+*     関数名：全可視ブロック解除 (clear_all_visible)
+* <pre>
+*
+*    １    機能
+*            要素を含むブロックの全可視ビットを落とす。
+*            要素エントリ(xmin/xmax)を書き換える前に呼び出すこと
+*
+*    ２    引数
+*            rowid      : 要素番号                      [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void Entity::clear_all_visible(rowid_t rowid) {
+    const size_t block = static_cast<size_t>(rowid) / BLOCK_SIZE;
+    const uint64_t bit = 1ULL << (block % 64);
+    ::std::atomic<uint64_t>& word = getVisibleMap()[block / 64];
+    // 既に落ちていれば書き込まない(キャッシュラインを汚さない)
+    if(word.load(::std::memory_order_relaxed) & bit)
+        word.fetch_and(~bit);
+}
+
+/**************************************************************************//**
+*
+*     関数名：変更範囲登録 (mark_dirty)
+* <pre>
+*
+*    １    機能
+*            要素エントリ(xmin/xmax/lock)に書き込んだTRIDと要素番号を
+*            変更範囲に含める。GCは変更範囲のみを走査し、最小TRIDが回収
+*            範囲に届かないエンティティは走査しない。
+*            範囲を先に広げてから最小TRIDを下げる(take_dirtyは逆順で
+*            取り出すため、取り出しと競合しても範囲の漏れはない)。
+*            既に含まれていれば書き込まない
+*
+*    ２    引数
+*            trid       : 書き込んだTRID                [入力]
+*            rowid      : 要素番号                      [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void Entity::mark_dirty(trid_t trid, rowid_t rowid) {
+    atomic_min(dirty_begin, rowid);
+    atomic_max(dirty_end, rowid + 1);
+    atomic_min(dirty_trid, trid);
+}
+
+/**************************************************************************//**
+*
+*     関数名：変更範囲取出し (take_dirty)
+* <pre>
+*
+*    １    機能
+*            最小TRIDが回収目標未満なら、変更範囲を取り出して空にする。
+*            取り出した範囲は走査中の変更範囲としてdone_dirtyまで保持し、
+*            他のサイクルが取り出した走査中の範囲が残っていれば(中断した
+*            サイクル)、それも含めて取り出す。
+*            取り出した範囲に回収目標以上のTRIDが残る要素は、GCが走査
+*            時にmark_dirtyで登録し直す
+*
+*    ２    引数
+*            target     : 回収目標(これ未満を回収する)  [入力]
+*            seq        : GCサイクル通番                [入力]
+*            begin      : 変更範囲の先頭                [出力]
+*            end        : 変更範囲の終端                [出力]
+*
+*    ３    戻り値
+*            true  : 走査が必要
+*            false : 変更なし(走査不要)
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+bool Entity::take_dirty(trid_t target, uint64_t seq, rowid_t& begin, rowid_t& end) {
+    getLock(Header::WRITE_LOCK);
+    // 中断したサイクルの走査中の範囲を引き継ぐ
+    begin = sweep_begin;
+    end = sweep_end;
+    if(dirty_trid.load() < target) {
+        dirty_trid.store(TRID_MAX);
+        begin = ::std::min(begin, dirty_begin.exchange(DIRTY_NONE));
+        end = ::std::max(end, dirty_end.exchange(0));
+    }
+    const bool ret = begin < end;
+    if(ret) {
+        sweep_seq = seq;
+        sweep_begin = begin;
+        sweep_end = end;
+    }
+    releaseLock();
+    return ret;
+}
+
+/**************************************************************************//**
+*
+*     関数名：変更範囲走査完了 (done_dirty)
+* <pre>
+*
+*    １    機能
+*            指定のサイクルが取り出した走査中の変更範囲を、走査完了として
+*            空にする。他のサイクルが引き継いでいれば何もしない
+*
+*    ２    引数
+*            seq        : GCサイクル通番                [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void Entity::done_dirty(uint64_t seq) {
+    getLock(Header::WRITE_LOCK);
+    if(sweep_seq == seq) {
+        sweep_begin = DIRTY_NONE;
+        sweep_end = 0;
+    }
+    releaseLock();
+}
+
+/**************************************************************************//**
+*
+*     関数名：全可視ブロック設定 (mark_block_visible)
+* <pre>
+*
+*    １    機能
+*            指定位置のブロックについて、全要素が使用中でxminが回収済み
+*            (コミット済み)、xmaxなしなら全可視ビットを立て、それ以外は
+*            落とす。GCがエンティティ単位の排他ロック中に呼び出す
+*
+*    ２    引数
+*            collecting : 新しい最古の未回収TRID        [入力]
+*            begin      : ブロック先頭の要素番号        [入力]
+*
+*    ３    戻り値
+*            true  : 全可視
+*            false : それ以外
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+bool Entity::mark_block_visible(trid_t coll, rowid_t begin) {
+    const size_t block = static_cast<size_t>(begin) / BLOCK_SIZE;
+    const size_t end = (block + 1) * BLOCK_SIZE;
+    // used_endを超えるブロックは全可視にしない
+    bool frozen = end <= static_cast<size_t>(used_end);
+    for(size_t i = block * BLOCK_SIZE; frozen && i < end; i++) {
+        const Entry& ent = entryAt(i);
+        frozen = ent.xmin.load() != TRID_MAX && ent.getXmin() < coll
+                && ent.xmax.load() == TRID_MAX;
+    }
+    ::std::atomic<uint64_t>& word = getVisibleMap()[block / 64];
+    const uint64_t bit = 1ULL << (block % 64);
+    if(frozen) word.fetch_or(bit);
+    else if(word.load(::std::memory_order_relaxed) & bit) word.fetch_and(~bit);
+    return frozen;
+}
+
+/**************************************************************************//**
+*
+*     関数名：空き要素登録 (mark_free_slot)
+* <pre>
+*
+*    １    機能
+*            空きマップの要素のビットを立てる。語が空きなしから空きありに
+*            なった場合のみ上段のビットを立てる。
+*            エンティティ単位の排他ロック中に呼び出すこと
+*
+*    ２    引数
+*            rowid      : 要素番号                      [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void Entity::mark_free_slot(rowid_t rowid) {
+    uint64_t* level = getFreeMap();
+    size_t pos = static_cast<size_t>(rowid);
+    for(size_t words = (reserve_line + 63) / 64; ; words = (words + 63) / 64) {
+        if(words == 0) words = 1;
+        uint64_t& word = level[pos / 64];
+        const bool had = word != 0;
+        word |= 1ULL << (pos % 64);
+        if(had || words == 1) break;
+        level += words;
+        pos /= 64;
+    }
+}
+
+/**************************************************************************//**
+*
+*     関数名：空き要素解除 (mark_used_slot)
+* <pre>
+*
+*    １    機能
+*            空きマップの要素のビットを落とす。語の空きがなくなった場合
+*            のみ上段のビットを落とす。
+*            エンティティ単位の排他ロック中に呼び出すこと
+*
+*    ２    引数
+*            rowid      : 要素番号                      [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void Entity::mark_used_slot(rowid_t rowid) {
+    used_num++;
+    uint64_t* level = getFreeMap();
+    size_t pos = static_cast<size_t>(rowid);
+    for(size_t words = (reserve_line + 63) / 64; ; words = (words + 63) / 64) {
+        if(words == 0) words = 1;
+        uint64_t& word = level[pos / 64];
+        word &= ~(1ULL << (pos % 64));
+        if(word != 0 || words == 1) break;
+        level += words;
+        pos /= 64;
+    }
+}
+
+/**************************************************************************//**
+*
+*     関数名：先頭の空き要素検索 (find_free_slot)
+* <pre>
+*
+*    １    機能
+*            空きマップの最上段から、各段の語の最下位ビット(tzcnt)を辿って
+*            最も小さい空き要素番号を求める。段数はlog64(MaxLine)。
+*            エンティティ単位の排他ロック中に呼び出すこと
+*
+*    ２    引数
+*            なし
+*
+*    ３    戻り値
+*            空き要素番号。空きがない場合はINVALID_ROWID
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+rowid_t Entity::find_free_slot() {
+    // 64^11 > 2^64 のため段数は11以下
+    uint64_t* levels[11];
+    size_t depth = 0;
+    uint64_t* level = getFreeMap();
+    for(size_t words = (reserve_line + 63) / 64; ; words = (words + 63) / 64) {
+        if(words == 0) words = 1;
+        levels[depth++] = level;
+        if(words == 1) break;
+        level += words;
+    }
+    size_t pos = 0;
+    while(depth > 0) {
+        const uint64_t word = levels[--depth][pos];
+        if(word == 0) return INVALID_ROWID;
+        pos = pos * 64 + static_cast<size_t>(__builtin_ctzll(word));
+    }
+    return static_cast<rowid_t>(pos);
 }
 
 /*--------1---------2---------3---------4---------5---------6---------7------*/
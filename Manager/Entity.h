@@ -41,17 +41,104 @@ public:
                                     // ([0～used_end]の範囲にデータが存在する)
     ::Entity::rowid_t free_begin;   ///< 空きエントリ開始位置([free_begin～
                                     // tuple_num]の範囲に空きが存在する)
+                                    // 割当ては空きマップで行い、参照用に保持
+    IndexType index_type;           ///< インデックス種別(インデックス領域のみ)
+    size_t  reserve_line;           ///< 確保済み要素数(MaxLineの拡張上限)
+                                    // 管理配列・要素本体・各マップの配置は
+                                    // この要素数で決まり、拡張で移動しない
+    ::Entity::rowid_t init_end;     ///< 初期化済みエントリ終端位置([init_end～
+                                    // MaxLine]は未初期化で暗黙の空き)
+    ::std::atomic<trid_t> dirty_trid;   ///< 前回GC以降に書き込んだ最小TRID
+                                        // (変更なしはTRID_MAX)
+    ::std::atomic<::Entity::rowid_t> dirty_begin;   ///< 変更要素範囲の先頭
+    ::std::atomic<::Entity::rowid_t> dirty_end;     ///< 変更要素範囲の終端
+                                        // (この位置を含まない、空はbegin>=end)
+    uint64_t sweep_seq;             ///< 走査中の変更範囲を取り出したGCサイクル通番
+    ::Entity::rowid_t sweep_begin;  ///< 走査中の変更範囲の先頭
+    ::Entity::rowid_t sweep_end;    ///< 走査中の変更範囲の終端(空はbegin>=end)
+                                    // 走査完了まで保持し、中断したサイクルの
+                                    // 範囲は次のサイクルが引き継ぐ
+                                    // (エンティティの排他ロック中のみ参照)
+    size_t  used_num;               ///< 使用中(予約中を含む)の要素数
+    ::std::atomic<size_t> reserved_num; ///< 予約中の要素数
+    ::Entity::rowid_t reserve_begin;    ///< 予約中の要素範囲の先頭
+    ::Entity::rowid_t reserve_end;      ///< 予約中の要素範囲の終端
+                                    // (この位置を含まない、空はbegin>=end)
+                                    // 変更範囲とは別に保持し、予約したセッションの
+                                    // 回収時のみ走査する(エンティティの排他ロック中)
+    ::std::atomic<uint64_t> reserve_checked;    ///< 予約を確認した時点の
+                                    // セッション回収数
+    uint32_t gc_threshold;          ///< 自動GCの使用率しきい値(%、0はなし)
     /**********************************************************************//**
     * 構造体名：共通メモリ管理機能 個別データ管理情報定義(ENTRY)
     **//**********************************************************************/
     class Entry {
     public:
-        trid_t xmin;                ///< 最小TRID(このID以上で可視)
-        trid_t xmax;                ///< 最大TRID(このID未満で可視)
-        trid_t lock;                ///< ロック取得TRID
+        /// ヒントビット：対象Trはコミット済み(コミットTRCCはxxx_ccに保持)
+        static const trid_t HINT_COMMITTED = 1uL << 63;
+        /// ヒントビット：対象Trはアボート済み
+        static const trid_t HINT_ABORTED   = 1uL << 62;
+        static const trid_t HINT_MASK = HINT_COMMITTED | HINT_ABORTED;
+        /// ヒントビット：コミットTRCCの記録中(両ビット、ヒントなしとして扱う)
+        static const trid_t HINT_BUSY = HINT_MASK;
+
+        ::std::atomic<trid_t> xmin; ///< 最小TRID(このID以上で可視)+ヒントビット
+        ::std::atomic<trid_t> xmax; ///< 最大TRID(このID未満で可視)+ヒントビット
+        trid_t   lock;              ///< ロック取得TRID
+        uint32_t xmin_cc;           ///< xminのコミットTRCC(下位32ビット)
+        uint32_t xmax_cc;           ///< xmaxのコミットTRCC(下位32ビット)
+
+        /// ヒントビットを除いたTRID
+        static inline trid_t strip(trid_t v) {
+            return v == TRID_MAX ? TRID_MAX : v & ~HINT_MASK;
+        }
+        /// ヒントビットを除いたxmin
+        inline trid_t getXmin() const { return strip(xmin.load()); }
+        /// ヒントビットを除いたxmax
+        inline trid_t getXmax() const { return strip(xmax.load()); }
+
+        /// 予約印：空き要素(xmin=TRID_MAX)のlockに予約したセッションを記録する
+        /// (上位ビット=印、セッションの世代の下位31ビット、セッション番号)
+        static const trid_t RESERVED = 1uL << 63;
+        /// 予約印の作成
+        static inline trid_t reserveMark(session_t session) {
+            return RESERVED | session;
+        }
+        /// 予約中の空き要素か
+        inline bool isReserved() const {
+            return xmin.load() == TRID_MAX && lock != TRID_MAX && (lock & RESERVED);
+        }
+        /// 予約したセッション
+        inline session_t getReservedSession() const {
+            return lock & ~RESERVED;
+        }
     };
+    // 走査カーネルはEntryを32バイト単位でまとめて読み込む
+    static_assert(sizeof(Entry) == 32, "Entry must be 32 bytes");
+    /// 要素ブロック可視判定の最大要素数(可視ビットマスクの幅)
+    /// 全可視マップも同じ要素数のブロック単位で1ビットを持つ
+    static const size_t BLOCK_SIZE = 64;
 
-    Entry tag_entries[0];         ///< 個別管理領域配列
+    /**********************************************************************//**
+    * 構造体名：物理配置(Layout)
+    *           管理情報・要素本体の位置を、領域先頭からのオフセットと要素
+    *           毎の間隔で表す。配置種別によらず同じ計算式で参照するため、
+    *           参照時に種別の分岐はない
+    *           SPLIT       : [管理情報×N][要素本体×N(詰める)]
+    *           ALIGNED     : [管理情報×N][要素本体×N(64バイト単位)]
+    *           INTERLEAVED : [管理情報+要素本体(64バイト単位)×N]
+    **//**********************************************************************/
+    class Layout {
+    public:
+        LayoutType type;            ///< 物理配置種別
+        size_t entry_offset;        ///< 先頭の管理情報のオフセット
+        size_t entry_stride;        ///< 管理情報の間隔
+        size_t tuple_offset;        ///< 先頭の要素本体のオフセット
+        size_t tuple_stride;        ///< 要素本体の間隔
+        size_t map_offset;          ///< 全可視マップのオフセット
+        size_t size;                ///< 領域全体のサイズ
+    };
+    Layout layout;                  ///< 物理配置
 
     /// テーブルステータス(enum)
     enum Status {
@@ -61,17 +148,145 @@ public:
     };
 
 public:
+    /**********************************************************************//**
+    *    関数名 : 物理配置取得 (getLayout)
+    *             要素数、要素サイズ、配置種別から各領域の配置を求める。
+    *             管理情報・要素本体の後ろに全可視マップ・空きマップを置く
+    *    引数   : num       :    確保済み要素数(ReserveLine)    [入力]
+    *             unit_size :    データサイズ(byte)             [入力]
+    *             type      :    物理配置種別                   [入力]
+    *    戻り値 : 物理配置
+    **//**********************************************************************/
+    static inline Layout getLayout(size_t num, size_t unit_size,
+            LayoutType type) {
+        Layout ly;
+        ly.type = type;
+        ly.entry_offset = roundUp(sizeof(Entity), sizeof(uint64_t));
+        ly.entry_stride = sizeof(Entry);
+        if(type == LAYOUT_INTERLEAVED) {
+            // 管理情報と要素本体の組をキャッシュライン単位に揃える
+            ly.entry_offset = roundUp(sizeof(Entity), CACHE_LINE);
+            ly.entry_stride = roundUp(sizeof(Entry) + unit_size, CACHE_LINE);
+            ly.tuple_offset = ly.entry_offset + sizeof(Entry);
+            ly.tuple_stride = ly.entry_stride;
+        } else {
+            ly.tuple_offset = roundUp(ly.entry_offset + sizeof(Entry) * num,
+                    CACHE_LINE);
+            ly.tuple_stride = type == LAYOUT_ALIGNED ?
+                    roundUp(unit_size, CACHE_LINE) : unit_size;
+        }
+        ly.map_offset = roundUp(ly.tuple_offset + ly.tuple_stride * num,
+                sizeof(uint64_t));
+        ly.size = ly.map_offset + sizeof(uint64_t) *
+                (getVisibleMapWords(num) + getFreeMapWords(num));
+        return ly;
+    }
+
     /**********************************************************************//**
     *    関数名 : 個別管理情報サイズ取得 (getSize)
     *             フィールド数、要素サイズから個別管理情報を確保するうえで
     *             必要なメモリサイズを取得する
-    *    引数   : num       :    フィールド数(LINE)     [入力]
+    *    引数   : num       :    確保済み要素数(ReserveLine)    [入力]
     *             unit_size :    データサイズ(byte)     [入力]
+    *             type      :    物理配置種別           [入力]
     *
     *    戻り値 : メモリサイズ(byte)
     **//**********************************************************************/
-    static inline size_t getSize(size_t num, size_t unit_size) {
-        return sizeof(Entity) + (sizeof(Entry) + unit_size) * num;
+    static inline size_t getSize(size_t num, size_t unit_size,
+            LayoutType type = LAYOUT_SPLIT) {
+        return getLayout(num, unit_size, type).size;
+    }
+
+    /**********************************************************************//**
+    *    関数名 : 境界切り上げ (roundUp)
+    *    引数   : v         :    値                     [入力]
+    *             unit      :    境界(2のべき乗)        [入力]
+    *    戻り値 : 切り上げた値
+    **//**********************************************************************/
+    static inline size_t roundUp(size_t v, size_t unit) {
+        return (v + unit - 1) & ~(unit - 1);
+    }
+
+    /**********************************************************************//**
+    *    関数名 : 全可視マップサイズ取得 (getVisibleMapWords)
+    *    引数   : num       :    フィールド数(LINE)     [入力]
+    *    戻り値 : 全可視マップの語数(64ビット単位)
+    **//**********************************************************************/
+    static inline size_t getVisibleMapWords(size_t num) {
+        const size_t blocks = (num + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        return (blocks + 63) / 64;
+    }
+
+    /**********************************************************************//**
+    *    関数名 : 空きマップサイズ取得 (getFreeMapWords)
+    *             空きマップは1要素1ビットの最下段から、下段の語毎に1ビットの
+    *             上段を1語になるまで積み重ねる
+    *    引数   : num       :    フィールド数(LINE)     [入力]
+    *    戻り値 : 空きマップの全段の語数(64ビット単位)
+    **//**********************************************************************/
+    static inline size_t getFreeMapWords(size_t num) {
+        size_t total = 0;
+        for(size_t words = (num + 63) / 64; ; words = (words + 63) / 64) {
+            if(words == 0) words = 1;
+            total += words;
+            if(words == 1) break;
+        }
+        return total;
+    }
+
+    /**********************************************************************//**
+    *    関数名 : 管理情報アドレス取得 (entryAt)
+    *             要素番号の管理情報を範囲チェックなしで取得する。
+    *             領域はページ境界にマップされるため、プロセス間で同じ
+    *             オフセット・境界になる
+    *    引数   : rowid     :    要素番号               [入力]
+    *    戻り値 : 管理情報
+    **//**********************************************************************/
+    inline Entry& entryAt(::Entity::rowid_t rowid) {
+        return *reinterpret_cast<Entry*>(reinterpret_cast<char*>(this)
+                + layout.entry_offset + layout.entry_stride * rowid);
+    }
+
+    /**********************************************************************//**
+    *    関数名 : 要素本体アドレス取得 (tupleAt)
+    *             要素番号の要素本体を範囲チェックなしで取得する
+    *    引数   : rowid     :    要素番号               [入力]
+    *    戻り値 : 要素本体の先頭アドレス
+    **//**********************************************************************/
+    inline char* tupleAt(::Entity::rowid_t rowid) {
+        return reinterpret_cast<char*>(this) + layout.tuple_offset
+                + layout.tuple_stride * rowid;
+    }
+
+    /**********************************************************************//**
+    *    関数名 : 全可視マップ先頭アドレス取得 (getVisibleMap)
+    *    引数   : なし
+    *    戻り値 : 全可視マップの先頭アドレス
+    **//**********************************************************************/
+    inline ::std::atomic<uint64_t>* getVisibleMap() {
+        return reinterpret_cast<::std::atomic<uint64_t>*>(
+                reinterpret_cast<char*>(this) + layout.map_offset);
+    }
+
+    /**********************************************************************//**
+    *    関数名 : 空きマップ先頭アドレス取得 (getFreeMap)
+    *             全可視マップの直後に置く。エンティティ単位の排他ロック中
+    *             のみ参照・更新する
+    *    引数   : なし
+    *    戻り値 : 空きマップ最下段の先頭アドレス
+    **//**********************************************************************/
+    inline uint64_t* getFreeMap() {
+        return reinterpret_cast<uint64_t*>(
+                getVisibleMap() + getVisibleMapWords(reserve_line));
+    }
+
+    /**********************************************************************//**
+    *    関数名 : 使用率取得 (getFillPercent)
+    *    引数   : なし
+    *    戻り値 : 使用中の要素数の確保済み要素数(ReserveLine)に対する割合(%)
+    **//**********************************************************************/
+    inline uint32_t getFillPercent() const {
+        return static_cast<uint32_t>(used_num * 100 / reserve_line);
     }
 
     /// 個別エンティティ情報アドレス取得
@@ -80,6 +295,32 @@ public:
     static bool check_tuple_readable(trid_t, Entity::Entry&);
     /// 領域操作可否判定
     static Status check_tuple_writable(trid_t, Entity::Entry&);
+private:
+    /// ヒントビットによる可視TRID取得
+    static trid_t get_visible_trid(trid_t, ::std::atomic<trid_t>&, uint32_t&);
+public:
+    /// 要素ブロック可視判定
+    uint64_t check_block_readable(trid_t, ::Entity::rowid_t, size_t);
+    /// 要素可視判定(全可視マップ使用)
+    bool check_row_readable(trid_t, ::Entity::rowid_t);
+    /// 全可視ブロック判定
+    bool is_all_visible(::Entity::rowid_t);
+    /// 全可視ブロック解除
+    void clear_all_visible(::Entity::rowid_t);
+    /// 全可視ブロック設定
+    bool mark_block_visible(trid_t, ::Entity::rowid_t);
+    /// 変更範囲登録
+    void mark_dirty(trid_t, ::Entity::rowid_t);
+    /// 変更範囲取出し
+    bool take_dirty(trid_t, uint64_t, ::Entity::rowid_t&, ::Entity::rowid_t&);
+    /// 変更範囲走査完了
+    void done_dirty(uint64_t);
+    /// 空き要素登録
+    void mark_free_slot(::Entity::rowid_t);
+    /// 空き要素解除
+    void mark_used_slot(::Entity::rowid_t);
+    /// 先頭の空き要素検索
+    ::Entity::rowid_t find_free_slot();
     /// ROW識別子チェック
     void checkRowID(::Entity::rowid_t);
     /// 個別データ管理情報アドレス取得
@@ -89,9 +330,24 @@ public:
     /// 個別データ本体設定
     void setTuple(::Entity::rowid_t, const ::Entity::AbstEntity&);
     /// 初期化
-    void init(const ::std::string&, const ::Entity::rowid_t, const size_t);
+    void init(const ::std::string&, const ::Entity::rowid_t, const size_t,
+            const size_t = 0, const LayoutType = LAYOUT_SPLIT);
+    /// 要素エントリ初期化
+    void init_slots(::Entity::rowid_t);
+    /// 空き要素エントリ取得
+    ::Entity::rowid_t next_free_slot();
+    /// 要素数拡張
+    bool expand();
     /// データフィールド作成
     ::Entity::rowid_t createTuple(trid_t);
+    /// データフィールド予約
+    size_t reserveTuples(::Entity::rowid_vec_t&, size_t);
+    /// 予約データフィールド作成
+    ::Entity::rowid_t claimTuple(trid_t, ::Entity::rowid_t);
+    /// データフィールド予約解除
+    void releaseTuples(const ::Entity::rowid_vec_t&);
+    /// 終了プロセスの予約回収
+    size_t recover_reserved();
     /// データフィールド更新
     ::Entity::rowid_t updateTuple(trid_t, ::Entity::rowid_t);
     /// データフィールド論理削除
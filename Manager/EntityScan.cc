@@ -0,0 +1,231 @@
+/**************************************************************************//**
+* @file
+*     モジュール名：個別管理情報クラス(全件走査カーネル)
+* <pre>
+*
+*    １  機能
+*          インデックスなしの全件走査で、要素エントリのxmin/xmaxをブロック
+*          単位でまとめて読み込み、可視ビットマスクを作成する。
+*          AVX2が使えるCPUでは4要素ずつベクトル比較し、それ以外はスカラーで
+*          同じ判定を行う。
+*          trid_collecting未満のTRIDは全てコミット扱いのため、xminが
+*          trid_collecting未満でxmaxなしの要素は可視、xmaxがtrid_collecting
+*          未満の要素と空き要素は不可視と確定する。確定しない要素のみ
+*          check_tuple_readableで判定する。
+*          全可視マップでビットが立っているブロックは読み込まずに全て可視とする。
+*          要素エントリが連続しない物理配置(INTERLEAVED)では、エントリ間隔を
+*          指定してギャザー読込みする
+*
+*    ２  関数名一覧
+*           ブロック判定(スカラー)   (filter_scalar)
+*           ブロック判定(AVX2)       (filter_avx2)
+*           要素ブロック可視判定     (check_block_readable)
+*
+*    ３  更新履歴
+*          REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+#include <Manager/Entity.h>
+#include <Manager/Snapshot.h>
+#include <Manager/Transaction.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "inc/SHMConst.h"
+#include "inc/SHMmacro.h"
+
+namespace SharedMemory
+{
+using ::Entity::rowid_t;
+
+namespace {
+/**************************************************************************//**
+*
+*     関数名： ブロック判定(スカラー)(filter_scalar)
+* <pre>
+*
+*    １    機能
+*            要素エントリを1件ずつ、可視確定・未確定に振り分ける
+*
+*    ２    引数
+*            base       : 先頭の要素エントリ            [入力]
+*            stride     : 要素エントリの間隔(byte)      [入力]
+*            num        : 要素数(BLOCK_SIZE以下)        [入力]
+*            collecting : 最古の未回収TRID              [入力]
+*            visible    : 可視確定のビットマスク        [出力]
+*            unknown    : 未確定のビットマスク          [出力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//*************************************************************************/
+void filter_scalar(const char* base, size_t stride, size_t num, trid_t coll,
+        uint64_t& visible, uint64_t& unknown) {
+    for(size_t i = 0; i < num; i++) {
+        const Entity::Entry& ent =
+                *reinterpret_cast<const Entity::Entry*>(base + stride * i);
+        const trid_t xmin = ent.xmin.load(::std::memory_order_relaxed);
+        const trid_t xmax = ent.xmax.load(::std::memory_order_relaxed);
+        const uint64_t bit = 1ULL << i;
+        // 空き要素は不可視
+        if(xmin == TRID_MAX) continue;
+        if(xmax == TRID_MAX) {
+            if((xmin & ~Entity::Entry::HINT_MASK) < coll) visible |= bit;
+            else unknown |= bit;
+        } else if((xmax & ~Entity::Entry::HINT_MASK) >= coll) {
+            unknown |= bit;
+        }
+        // xmaxが回収済みTRIDなら削除コミット済みで不可視
+    }
+}
+
+#if defined(__x86_64__)
+/**************************************************************************//**
+*
+*     関数名： ブロック判定(AVX2)(filter_avx2)
+* <pre>
+*
+*    １    機能
+*            要素エントリ(32バイト)を4件ずつ読み込み、xmin/xmaxを
+*            それぞれ1レジスタに並べ替えて比較する。エントリが連続しない
+*            場合は間隔を指定してxmin/xmaxをギャザー読込みする。
+*            端数はスカラーで判定する。
+*            ヒントビットを除いたTRIDは2^62未満のため符号付き比較で足りる
+*
+*    ２    引数
+*            filter_scalarと同じ
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//*************************************************************************/
+__attribute__((target("avx2")))
+void filter_avx2(const char* base, size_t stride, size_t num, trid_t coll,
+        uint64_t& visible, uint64_t& unknown) {
+    const __m256i strip = _mm256_set1_epi64x(
+            static_cast<int64_t>(~Entity::Entry::HINT_MASK));
+    const __m256i none = _mm256_set1_epi64x(-1);
+    const __m256i vcoll = _mm256_set1_epi64x(static_cast<int64_t>(coll));
+    const bool packed = stride == sizeof(Entity::Entry);
+    const __m256i vidx = _mm256_set_epi64x(
+            static_cast<int64_t>(stride * 3), static_cast<int64_t>(stride * 2),
+            static_cast<int64_t>(stride), 0);
+    size_t i = 0;
+    for(; i + 4 <= num; i += 4) {
+        const char* p = base + stride * i;
+        __m256i xmin, xmax;
+        if(packed) {
+            const __m256i* v = reinterpret_cast<const __m256i*>(p);
+            // 1要素 = [xmin, xmax | lock, cc]
+            const __m256i e0 = _mm256_loadu_si256(v);
+            const __m256i e1 = _mm256_loadu_si256(v + 1);
+            const __m256i e2 = _mm256_loadu_si256(v + 2);
+            const __m256i e3 = _mm256_loadu_si256(v + 3);
+            // [xmin0, xmin1 | lock0, lock1]・[xmax0, xmax1 | cc0, cc1]
+            const __m256i lo01 = _mm256_unpacklo_epi64(e0, e1);
+            const __m256i hi01 = _mm256_unpackhi_epi64(e0, e1);
+            const __m256i lo23 = _mm256_unpacklo_epi64(e2, e3);
+            const __m256i hi23 = _mm256_unpackhi_epi64(e2, e3);
+            xmin = _mm256_permute2x128_si256(lo01, lo23, 0x20);
+            xmax = _mm256_permute2x128_si256(hi01, hi23, 0x20);
+        } else {
+            const long long* q = reinterpret_cast<const long long*>(p);
+            xmin = _mm256_i64gather_epi64(q, vidx, 1);
+            xmax = _mm256_i64gather_epi64(q + 1, vidx, 1);
+        }
+
+        const __m256i minFree = _mm256_cmpeq_epi64(xmin, none);
+        const __m256i maxNone = _mm256_cmpeq_epi64(xmax, none);
+        const __m256i minOld = _mm256_cmpgt_epi64(vcoll,
+                _mm256_and_si256(xmin, strip));
+        const __m256i maxOld = _mm256_andnot_si256(maxNone,
+                _mm256_cmpgt_epi64(vcoll, _mm256_and_si256(xmax, strip)));
+        const __m256i vis = _mm256_andnot_si256(minFree,
+                _mm256_and_si256(minOld, maxNone));
+        const __m256i dead = _mm256_or_si256(minFree, maxOld);
+
+        const uint64_t v = static_cast<uint64_t>(
+                _mm256_movemask_pd(_mm256_castsi256_pd(vis)));
+        const uint64_t d = static_cast<uint64_t>(
+                _mm256_movemask_pd(_mm256_castsi256_pd(dead)));
+        visible |= v << i;
+        unknown |= (~(v | d) & 0xFULL) << i;
+    }
+    if(i < num) {
+        uint64_t v = 0, u = 0;
+        filter_scalar(base + stride * i, stride, num - i, coll, v, u);
+        visible |= v << i;
+        unknown |= u << i;
+    }
+}
+#endif
+}  // namespace
+
+/**************************************************************************//**
+*
+*     関数名： 要素ブロック可視判定(check_block_readable)
+* <pre>
+*
+*    １    機能
+*            指定位置からnum件の要素の可視判定をまとめて行う。
+*            スレッドで有効なスナップショットがあれば、その作成時の
+*            trid_collectingで確定判定する。
+*            全体管理領域の共有ロック中に呼び出すこと
+*
+*    ２    引数
+*            self_trid  : 自トランザクションID          [入力]
+*            begin      : 先頭の要素番号                [入力]
+*            num        : 要素数(BLOCK_SIZE以下)        [入力]
+*
+*    ３    戻り値
+*            可視ビットマスク(ビットiがbegin+iの要素)
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//*************************************************************************/
+uint64_t Entity::check_block_readable(trid_t trid, rowid_t begin, size_t num) {
+    if(num == 0) return 0;
+    if(num > BLOCK_SIZE) OUT_OF_RANGE("num");
+    checkRowID(begin);
+    checkRowID(begin + static_cast<rowid_t>(num) - 1);
+
+    // 全可視ブロックは全要素が可視
+    if(begin % BLOCK_SIZE == 0 && is_all_visible(begin))
+        return num == BLOCK_SIZE ? ~0ULL : (1ULL << num) - 1;
+
+    const Snapshot* snap = Snapshot::getCurrent(trid);
+    const trid_t coll = snap != nullptr ? snap->getCollecting() :
+            Transaction::getTrans().trid_collecting.load(::std::memory_order_acquire);
+
+    const char* base = reinterpret_cast<const char*>(&entryAt(begin));
+    const size_t stride = layout.entry_stride;
+    uint64_t visible = 0, unknown = 0;
+#if defined(__x86_64__)
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    if(has_avx2)
+        filter_avx2(base, stride, num, coll, visible, unknown);
+    else
+#endif
+        filter_scalar(base, stride, num, coll, visible, unknown);
+
+    // 未確定の要素のみ個別に判定する
+    while(unknown != 0) {
+        const int bit = __builtin_ctzll(unknown);
+        unknown &= unknown - 1;
+        if(check_tuple_readable(trid, entryAt(begin + bit)))
+            visible |= 1ULL << bit;
+    }
+    return visible;
+}
+
+/*--------1---------2---------3---------4---------5---------6---------7------*/
+}    // SharedMemory
@@ -0,0 +1,79 @@
+/**************************************************************************//**
+* @file
+*     モジュール名：共通メモリ管理機能 futex操作定義
+* <pre>
+*
+*    １  機能
+*          共有メモリ上の32ビットワードに対するfutex待ち合わせ・起床を定義する
+*
+*    ２  更新履歴
+*          REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+#ifndef SHAREDMEMORY_FUTEX_H_
+#define SHAREDMEMORY_FUTEX_H_
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <climits>
+#include <ctime>
+
+#include <atomic>
+#include <cstdint>
+
+namespace SharedMemory
+{
+/**************************************************************************//**
+* クラス名 : futex操作クラス(Futex)
+*            プロセス間で共有する32ビットワードの待ち合わせ・起床を行う。
+*            共有メモリ上で使用するためFUTEX_PRIVATE_FLAGは指定しない。
+*            ワードは32ビット幅のアトミック型(列挙型を含む)であること。
+**//**************************************************************************/
+class Futex {
+public:
+    /**********************************************************************//**
+    *   関数名 : 待ち合わせ(wait)
+    *            ワードの値がvalである間、起床またはタイムアウトまで待つ
+    *   引数   : word  : 待ち合わせ対象ワード                [入力]
+    *            val   : 待ち合わせ時の期待値                [入力]
+    *            msec  : 最大待ち時間(ms) 0は無制限          [入力]
+    *   戻り値 : 0     : 起床(または値が既に異なる)
+    *            -1    : タイムアウトまたは割込み(errno参照)
+    **//**********************************************************************/
+    template<typename T>
+    static inline int wait(::std::atomic<T>& word, T val, uint64_t msec = 0) {
+        static_assert(sizeof(word) == sizeof(uint32_t), "futex word is 32bit");
+        struct timespec ts = {
+            static_cast<time_t>(msec / 1000uL),
+            static_cast<long>((msec % 1000uL) * 1000000uL)
+        };
+        long ret = ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word),
+                FUTEX_WAIT, static_cast<uint32_t>(val), msec == 0 ? nullptr : &ts, nullptr, 0);
+        return ret < 0 && errno != EAGAIN ? -1 : 0;
+    }
+
+    /**********************************************************************//**
+    *   関数名 : 起床(wake)
+    *            ワードで待ち合わせているプロセスを起床する
+    *   引数   : word  : 待ち合わせ対象ワード                [入力]
+    *            num   : 起床する最大数(省略時は全て)        [入力]
+    *   戻り値 : 起床したプロセス数
+    **//**********************************************************************/
+    template<typename T>
+    static inline int wake(::std::atomic<T>& word, int num = INT_MAX) {
+        static_assert(sizeof(word) == sizeof(uint32_t), "futex word is 32bit");
+        return static_cast<int>(::syscall(SYS_futex,
+                reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, num,
+                nullptr, nullptr, 0));
+    }
+
+private:
+    Futex();    ///< コンストラクタ(なし)
+};
+
+/*--------1---------2---------3---------4---------5---------6---------7------*/
+}  // end namespace SharedMemory
+
+#endif /* SHAREDMEMORY_FUTEX_H_ */
@@ -0,0 +1,57 @@
+/**************************************************************************//**
+* @file
+*     モジュール名：共通メモリ管理機能 ハッシュインデックス用インタフェース
+* <pre>
+*
+*    １  機能
+*          ハッシュインデックスで使用するハッシュ値の取得インタフェースを
+*          定義する。インデクサ・インデックスマッチャの実装クラスが
+*          追加で継承する
+*
+*    ２  更新履歴
+*          REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+#ifndef SHAREDMEMORY_HASHINDEXER_H_
+#define SHAREDMEMORY_HASHINDEXER_H_
+
+#include <Entity/AppTable.h>
+#include <cstdint>
+
+namespace SharedMemory
+{
+/**************************************************************************//**
+* クラス名 : ハッシュインデクサ(HashIndexer)
+* <pre>
+*          ハッシュインデックスに登録するタプルのハッシュ値を返す。
+*          ハッシュインデックスのインデクサ(ImplIndexer)は本クラスも継承
+*          すること。compareで一致するタプルは同じハッシュ値を返すこと
+* </pre>
+**//**************************************************************************/
+class HashIndexer {
+public:
+    virtual ~HashIndexer() { }
+    /// タプルのハッシュ値取得
+    virtual uint64_t hash(const ::Entity::AbstEntity&) const = 0;
+};
+
+/**************************************************************************//**
+* クラス名 : ハッシュマッチャ(HashMatcher)
+* <pre>
+*          ハッシュインデックスを一致検索する検索値のハッシュ値を返す。
+*          本クラスを継承しないインデックスマッチャでは、ハッシュ
+*          インデックスは全件走査となる。ハッシュ値が同じタプルはmatch
+*          で絞り込むため、matchは一致で0を返すこと
+* </pre>
+**//**************************************************************************/
+class HashMatcher {
+public:
+    virtual ~HashMatcher() { }
+    /// 検索値のハッシュ値取得
+    virtual uint64_t hash() const = 0;
+};
+
+/*--------1---------2---------3---------4---------5---------6---------7------*/
+}  // end namespace SharedMemory
+
+#endif /* SHAREDMEMORY_HASHINDEXER_H_ */
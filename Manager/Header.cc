@@ -11,9 +11,18 @@
 * </pre>
 **//**************************************************************************/
 
+#include <Init/Initializer.h>
 #include <Manager/Header.h>
+#include <Manager/Transaction.h>
+#include <cstddef>
 #include <cstring>
 #include <unistd.h>
+
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
 #include "inc/SHMmacro.h"
 
 namespace SharedMemory
@@ -22,6 +31,62 @@ using ::std::string;
 
 const string Header::FILE_HEADER = "SHM::";
 const string Header::FILE_EXP = ".table";
+const string Header::SHM_PREFIX = "shm:";
+
+/**************************************************************************//**
+* クラス名 : プロセス内ロック(ProcessLock)
+* <pre>
+*          管理領域毎にプロセス内のスレッド間を排他する。ロック実体(fcntl・
+*          共有メモリ内ロック)はプロセス単位で1つだけ保持し、共有ロックは
+*          最初のスレッドが取得して最後のスレッドが開放する。
+*          fcntlのロックはプロセスに属するため、スレッド間の排他はここで行う
+* </pre>
+**//**************************************************************************/
+class ProcessLock {
+public:
+    ::std::shared_mutex rwlock;     ///< スレッド間のリードライトロック
+    ::std::mutex        mutex;      ///< readers・sessionの排他
+    int                 readers;    ///< 共有ロックを保持するスレッド数
+    uint32_t            session;    ///< 共有ロック取得時のセッション番号
+
+    ProcessLock() : readers(0), session(SharedLock::NO_SESSION) { }
+};
+
+namespace {
+/// ロック保持状態(再入管理用)
+class LockState {
+public:
+    Header::Lock status;    ///< 保持しているロック種別
+    int          count;     ///< 再入回数
+    ProcessLock* process;   ///< プロセス内ロック
+
+    LockState() : status(Header::UNLOCK), count(0), process(nullptr) { }
+};
+
+/// 管理領域毎のロック保持状態(スレッド単位)
+/// 再入は共有メモリに触れずにここで数え、実際のロック変更時のみ
+/// 管理領域のロック実体を操作する
+thread_local ::std::unordered_map<const Header*, LockState> lock_table;
+
+/// 管理領域毎のプロセス内ロック(プロセス単位、開放しない)
+::std::mutex process_mutex;
+::std::unordered_map<const Header*, ::std::unique_ptr<ProcessLock>> process_table;
+
+/// ロック実体の保持を記録するセッション番号(未登録ならNO_SESSION)
+uint32_t currentSession() {
+    const session_t key = Transaction::getSelfSession();
+    return key == SESSION_NONE ? SharedLock::NO_SESSION
+            : static_cast<uint32_t>(key & 0xFFFFFFFF);
+}
+
+/// プロセス内ロック取得(なければ作成する)
+ProcessLock& getProcessLock(const Header* header) {
+    ::std::lock_guard<::std::mutex> guard(process_mutex);
+    ::std::unique_ptr<ProcessLock>& lock = process_table[header];
+    if(!lock) lock.reset(new ProcessLock());
+    return *lock;
+}
+}
 
 /**************************************************************************//**
 *
@@ -46,13 +111,15 @@ void Header::init(const string& memName, const msec_t to,
         const size_t maxLine, const size_t memSize, const size_t uSize) {
 
     name = memName;
-    lock_count = 0;
-    lock_status = UNLOCK;
+#ifdef PTHREAD_MUTEX
+    rwlock.init();
+#endif
 
     time_out = to;
-    max_line = maxLine;
+    max_line.store(maxLine, ::std::memory_order_relaxed);
     size = memSize;
     unit_size = uSize;
+    map_option = 0;
 }
 
 /**************************************************************************//**
@@ -62,10 +129,16 @@ void Header::init(const string& memName, const msec_t to,
 *
 *    １    機能
 *            エンティティ名からロックファイルを取得してロックを取得し、
-*            対応するロックオブジェクトを利用可能にする
+*            対応するロックオブジェクトを利用可能にする。
+*            再入はスレッド単位で数え、スレッド間はプロセス内ロックで
+*            排他する。
+*            共有ロックから排他ロックへの変更は、共有ロックを開放してから
+*            取り直すため原子的ではない。変更の間に他のプロセス・スレッドが
+*            更新できるため、呼出し元は共有ロック中に読み込んだ内容を
+*            排他ロック取得後に確認し直すこと
 *
 *    ２    引数
-*            なし
+*            status   : 取得するロック種別                     [入力]
 *
 *    ３    戻り値
 *            OK  : 正常終了
@@ -80,38 +153,36 @@ void Header::getLock(Lock status) {
     if(status != READ_LOCK && status != WRITE_LOCK)
         LOCK_FAILED("ロックの取得に失敗しました：" << name);
 
+    LockState& state = lock_table[this];
     // WRITE_LOCKに変える時以外はカウントするだけにする
-    if(lock_count != 0) {
-        lock_count++;
-        // WRITE->WRITE, WRITE->READは変えない
-        if(lock_status == WRITE_LOCK) return;
-        // READ->READも変えない
-        if(lock_status == READ_LOCK && status == READ_LOCK) return;
-    } else {
-        this->lock_status = UNLOCK; // ロック種別：解除
-        struct stat buf;            // ファイルステータス取得
-        if(::fstat(this->fd, &buf) != 0) buf.st_size = -1;
-        long fsize = buf.st_size;
-        if(fsize < 0) {
-            releaseLock();
-            LOCK_FAILED("情報取得に失敗しました：" << name);
+    if(state.count != 0) {
+        // WRITE->WRITE, WRITE->READ, READ->READは変えない
+        if(state.status == WRITE_LOCK || status == READ_LOCK) {
+            state.count++;
+            return;
         }
-        // ロック構造体情報設定
-        flck.l_whence = SEEK_SET; // ファイル最初から
-        flck.l_start = 0;         // ファイルの0バイト目から
-        flck.l_len = fsize;       // ファイルサイズ
-        flck.l_pid = getpid();
-        lock_count = 1;
     }
-
-    lock_status = status;
+    if(state.process == nullptr) state.process = &getProcessLock(this);
+    ProcessLock& process = *state.process;
 
     // ロックを取得するまで待つ設定でロックの取得
-    if(::fcntl(fd, F_SETLKW, &flck) < 0) {
-        releaseLock();
-        LOCK_FAILED("ロックの取得に失敗しました：" << name);
+    if(state.count != 0) {
+        // 共有ロックは排他ロックに変更できないため、開放してから取り直す
+        unlockProcess(process, READ_LOCK);
+        try {
+            lockProcess(process, WRITE_LOCK);
+        } catch(...) {
+            // 取得済みの共有ロックは元に戻す
+            lockProcess(process, READ_LOCK);
+            throw;
+        }
+    } else {
+        lockProcess(process, status);
     }
-    SHM_LOCK_LOG("fd:%d type:%d count:%d", fd, flck.l_type, lock_count);
+
+    state.status = status;
+    state.count++;
+    SHM_LOCK_LOG("name:%s type:%d count:%d", name.c_str(), status, state.count);
 
     return;
 }
@@ -136,21 +207,236 @@ void Header::getLock(Lock status) {
 * </pre>
 **//**************************************************************************/
 void Header::releaseLock() {
-    if(lock_count == 0) return;
-    if(lock_status == UNLOCK) return;
-
-    lock_count--;
-    if(lock_count > 0) return;
-    // ロック構造体情報設定
-    lock_status = UNLOCK;   // ロック種別：解除
-    // その他のパラメータはopen時に作られている
-    // ロックを解除する。
+    auto it = lock_table.find(this);
+    if(it == lock_table.end() || it->second.count == 0) return;
+
+    LockState& state = it->second;
+    if(state.count > 1) {
+        state.count--;
+        return;
+    }
+    // ロックを解除する。プロセス内ロックの参照は次回のために残す
+    Lock status = state.status;
+    state.status = UNLOCK;
+    state.count = 0;
+    unlockProcess(*state.process, status);
+
+    SHM_LOCK_LOG("name:%s type:%d count:%d", name.c_str(), UNLOCK, 0);
+    return;
+}
+
+/**************************************************************************//**
+*
+*     関数名：プロセス内ロックとロック実体の取得 (lockProcess)
+* <pre>
+*
+*    １    機能
+*            プロセス内ロックを取得し、ロック実体を取得する。
+*            共有ロックはプロセス内で最初のスレッドのみロック実体を取得し、
+*            排他ロックはプロセス内の他のスレッドの開放を待ってから取得する
+*
+*    ２    引数
+*            process  : プロセス内ロック                       [入力]
+*            status   : 取得するロック種別                     [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void Header::lockProcess(ProcessLock& process, Lock status) {
+    if(status == WRITE_LOCK) {
+        process.rwlock.lock();
+        try {
+            acquireLock(WRITE_LOCK, SharedLock::NO_SESSION);
+        } catch(...) {
+            process.rwlock.unlock();
+            throw;
+        }
+        return;
+    }
+
+    process.rwlock.lock_shared();
+    try {
+        ::std::lock_guard<::std::mutex> guard(process.mutex);
+        if(process.readers == 0) {
+            // 開放時は取得時のセッションで開放する
+            const uint32_t session = currentSession();
+            acquireLock(READ_LOCK, session);
+            process.session = session;
+        }
+        process.readers++;
+    } catch(...) {
+        process.rwlock.unlock_shared();
+        throw;
+    }
+}
+
+/**************************************************************************//**
+*
+*     関数名：プロセス内ロックとロック実体の開放 (unlockProcess)
+* <pre>
+*
+*    １    機能
+*            ロック実体を開放し、プロセス内ロックを開放する。
+*            共有ロックはプロセス内で最後のスレッドのみロック実体を開放する
+*
+*    ２    引数
+*            process  : プロセス内ロック                       [入力]
+*            status   : 取得済みのロック種別                   [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void Header::unlockProcess(ProcessLock& process, Lock status) {
+    if(status == WRITE_LOCK) {
+        try {
+            freeLock(WRITE_LOCK, SharedLock::NO_SESSION);
+        } catch(...) {
+            process.rwlock.unlock();
+            throw;
+        }
+        process.rwlock.unlock();
+        return;
+    }
+
+    try {
+        ::std::lock_guard<::std::mutex> guard(process.mutex);
+        if(--process.readers == 0) freeLock(READ_LOCK, process.session);
+    } catch(...) {
+        process.rwlock.unlock_shared();
+        throw;
+    }
+    process.rwlock.unlock_shared();
+}
+
+/**************************************************************************//**
+*
+*     関数名：ロック実体の取得 (acquireLock)
+* <pre>
+*
+*    １    機能
+*            ロック実体を取得する。プロセス内ロックの取得中に呼び出すため、
+*            プロセス単位では未取得の状態から取得する。
+*            PTHREAD_MUTEX定義時は共有メモリ内のリードライトロックを、
+*            未定義時はファイルロック(fcntl)を使用する。
+*            共有メモリ内ロックの排他ロックは、共有ロックの開放を一定時間
+*            待っても開放されなければ、終了したプロセスのセッションを回収
+*            (保持していた共有ロックも開放)してから待ち直す
+*
+*    ２    引数
+*            status   : 取得するロック種別                     [入力]
+*            session  : 共有ロックを記録するセッション番号     [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void Header::acquireLock(Lock status, uint32_t session) {
+#ifdef PTHREAD_MUTEX
+    if(status != WRITE_LOCK) {
+        rwlock.lockShared(session);
+        return;
+    }
+    rwlock.lock();
+    try {
+        while(!rwlock.waitShared(SharedLock::RECOVER_MSEC)) {
+            // 共有ロックを保持したまま終了したプロセスを回収する
+            if(Initializer::transaction_addr != nullptr)
+                Transaction::getTrans().checkSessions();
+        }
+    } catch(...) {
+        rwlock.unlock();
+        throw;
+    }
+#else
+    (void)session;
+    // ロック構造体はプロセス毎に異なるため共有メモリには置かない
+    struct flock flck = {};
+    flck.l_type = status;
+    flck.l_whence = SEEK_SET; // ファイル最初から
+    flck.l_start = 0;         // ファイルの0バイト目から
+    flck.l_len = 0;           // ファイル終端まで
+    if(::fcntl(fd, F_SETLKW, &flck) < 0)
+        LOCK_FAILED("ロックの取得に失敗しました：" << name);
+#endif
+}
+
+/**************************************************************************//**
+*
+*     関数名：ロック実体の開放 (freeLock)
+* <pre>
+*
+*    １    機能
+*            acquireLockで取得したロック実体を開放する
+*
+*    ２    引数
+*            status   : 取得済みのロック種別                   [入力]
+*            session  : 共有ロックを記録したセッション番号     [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void Header::freeLock(Lock status, uint32_t session) {
+#ifdef PTHREAD_MUTEX
+    if(status == WRITE_LOCK) {
+        rwlock.unlock();
+    } else {
+        rwlock.unlockShared(session);
+    }
+#else
+    (void)status;
+    (void)session;
+    struct flock flck = {};
+    flck.l_type = UNLOCK;
+    flck.l_whence = SEEK_SET;
+    flck.l_start = 0;
+    flck.l_len = 0;
     if(::fcntl(fd, F_SETLK, &flck) < 0)
         LOCK_FAILED("ロックの解除に失敗しました：" << name);
+#endif
+}
 
-    lock_count = 0;
-    SHM_LOCK_LOG("fd:%d type:%d count:%d", fd, flck.l_type, lock_count);
-    return;
+/**************************************************************************//**
+*
+*     関数名：終了したセッションのロック回収 (releaseSession)
+* <pre>
+*
+*    １    機能
+*            終了したプロセスのセッションが保持していた共有ロックを開放する。
+*            ファイルロックはプロセスの終了時に開放されるため何もしない
+*
+*    ２    引数
+*            session  : セッション番号                       [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void Header::releaseSession(uint32_t session) {
+#ifdef PTHREAD_MUTEX
+    if(rwlock.releaseSession(session))
+        WARN_LOG("終了プロセスの共有ロックを回収しました：" << name
+                << " session:" << session);
+#else
+    (void)session;
+#endif
 }
 
 /**************************************************************************//**
@@ -173,8 +459,35 @@ void Header::releaseLock() {
 **//**************************************************************************/
 void Header::attatchLog() const {
     INFO_LOG("アタッチ情報:%p Name:%s / MaxLine:%lu / TimeOut:%lu / "
-            "MemorySize:%lu / UnitSize:%lu", this, name.c_str(), max_line,
-            time_out, size, unit_size);
+            "MemorySize:%lu / UnitSize:%lu / MapOption:%u", this, name.c_str(),
+            getMaxLine(), time_out, size, unit_size, map_option);
+}
+
+/**************************************************************************//**
+*
+*     関数名：ファイルからマップオプション取得 (readMapOption)
+* <pre>
+*
+*    １    機能
+*          マップ前の共有メモリファイルから、先頭の管理領域に記録された
+*          マップオプションを読み込む
+*
+*    ２    引数
+*            fd     :   共有メモリファイルのディスクリプタ  [入力]
+*
+*    ３    戻り値
+*            マップオプション(読込めない場合は0)
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+uint32_t Header::readMapOption(int fd) {
+    uint32_t opt = 0;
+    if(::pread(fd, &opt, sizeof(opt), offsetof(Header, map_option))
+            != static_cast<ssize_t>(sizeof(opt)))
+        return 0;
+    return opt;
 }
 
 /*--------1---------2---------3---------4---------5---------6---------7------*/
@@ -15,9 +15,11 @@
 
 //#define PTHREAD_MUTEX
 #include <Entity/AppTable.h>
+#include <Manager/SharedLock.h>
 #include <fcntl.h>
 #include <sys/stat.h>
 
+#include <atomic>
 #include <string>
 
 #include "inc/SHMConst.h"
@@ -27,6 +29,8 @@ namespace SharedMemory
 typedef uint64_t msec_t;                        ///< ミリ秒(64ビット符号なし整数)
 static const msec_t INVALID_MSEC  = ~0uL;       ///< ミリ秒無効値
 
+class ProcessLock;                              ///< プロセス内ロック(Header.cc)
+
 /**************************************************************************//**
 *     クラス名：共通メモリ管理機能 基盤共有メモリ構造ヘッダ
 *     (CSharedMemoryHeader)
@@ -40,7 +44,9 @@ private:
     size_t size;                                    ///< メモリサイズ
     int    fd;                                      ///< ファイルディスクプリタ
     ::Entity::entityname_t   name;      ///< エンティティ名
-    flock  flck;                                    ///< flock テーブル
+#ifdef PTHREAD_MUTEX
+    SharedLock rwlock;                              ///< 共有メモリ内ロック
+#endif
 
 public:
     /// ロック種別
@@ -50,20 +56,35 @@ public:
         UNLOCK     = F_UNLCK
     };
 
-private:
-    Lock lock_status;                               ///< ロック種別
-    int lock_count;                                 ///< ロックカウンタ
+    /// マップオプション(ビット和)
+    enum MapOption {
+        MAP_OPT_HUGE     = 1,   ///< ヒュージページ(<HugePages>)
+        MAP_OPT_POPULATE = 2,   ///< 事前フォールト(<Populate>)
+        MAP_OPT_LOCK     = 4    ///< メモリロック(<Lock>)
+    };
 
+private:
     msec_t time_out;                                ///< タイムアウト時間(ms)
-    size_t max_line;                                ///< 要素数
+    ::std::atomic<size_t> max_line;                 ///< 要素数(拡張は排他ロック中)
     size_t unit_size;                               ///< ユニットサイズ
+    uint32_t map_option;                            ///< マップオプション
 
     /// コントラクタ(無効)
     Header();
 
+    /// プロセス内ロックとロック実体の取得
+    void lockProcess(ProcessLock&, Lock);
+    /// プロセス内ロックとロック実体の開放
+    void unlockProcess(ProcessLock&, Lock);
+    /// ロック実体の取得
+    void acquireLock(Lock, uint32_t);
+    /// ロック実体の開放
+    void freeLock(Lock, uint32_t);
+
 public:
     static const ::std::string FILE_HEADER;
     static const ::std::string FILE_EXP;
+    static const ::std::string SHM_PREFIX;      ///< POSIX共有メモリ指定の接頭辞
 
     /// 初期化
     void init(const ::std::string&, const msec_t,
@@ -73,9 +94,38 @@ public:
     void getLock(Lock);
     /// ロック開放
     void releaseLock();
+    /// 終了したセッションのロック回収
+    void releaseSession(uint32_t);
 
     /// 割り当てログ採取
     void attatchLog() const;
+    /// ファイルからマップオプション取得
+    static uint32_t readMapOption(int);
+
+    /**********************************************************************//**
+    *     関数名：マップオプション取得(getMapOption)
+    * <pre>
+    *           作成時に指定したマップオプションを取得する
+    *    引数   : なし
+    *    戻り値 : マップオプション(MapOptionのビット和)
+    * </pre>
+    **//**********************************************************************/
+    inline uint32_t getMapOption() const {
+        return map_option;
+    }
+
+    /**********************************************************************//**
+    *     関数名：マップオプション設定(setMapOption)
+    * <pre>
+    *           マップオプションを記録し、アタッチするプロセスも同じ
+    *           オプションでマップできるようにする
+    *    引数   : マップオプション(MapOptionのビット和)
+    *    戻り値 : なし
+    * </pre>
+    **//**********************************************************************/
+    inline void setMapOption(const uint32_t opt) {
+        map_option = opt;
+    }
 
     /**********************************************************************//**
     *     関数名：ファイルディスクプリタ取得(getFileDiscpriter)
@@ -117,13 +167,15 @@ public:
     *
     *     関数名：管理領域データ最大数取得(getMaxLine)
     * <pre>
-    *     管理テーブルに保持しているデータ最大数を取得する
+    *     管理テーブルに保持しているデータ最大数を取得する。
+    *     拡張はロックなしで参照されるため、拡張した要素の初期化が見える
+    *     よう取得で読み込む
     *    引数 : なし
     *    戻り値 : データ数
     * </pre>
     **//**********************************************************************/
     inline size_t getMaxLine() const {
-        return max_line;
+        return max_line.load(::std::memory_order_acquire);
     }
 
     /**********************************************************************//**
@@ -161,6 +213,33 @@ public:
     inline const ::std::string getName() const {
         return name;
     }
+
+protected:
+    /**********************************************************************//**
+    *     関数名：管理領域メモリサイズ設定(setMemorySize)
+    * <pre>
+    *           派生クラスが管理情報を領域末尾に追加する場合に、初期化時に
+    *           領域全体のメモリサイズを設定する
+    *    引数   : メモリサイズ(bytes)
+    *    戻り値 : なし
+    * </pre>
+    **//**********************************************************************/
+    inline void setMemorySize(const size_t memSize) {
+        size = memSize;
+    }
+
+    /**********************************************************************//**
+    *     関数名：管理領域データ最大数設定(setMaxLine)
+    * <pre>
+    *           確保済みの領域内で要素数を拡張する。拡張した要素を初期化して
+    *           から呼び出すこと
+    *    引数   : 要素数
+    *    戻り値 : なし
+    * </pre>
+    **//**********************************************************************/
+    inline void setMaxLine(const size_t maxLine) {
+        max_line.store(maxLine, ::std::memory_order_release);
+    }
 };
 
 }  // end namespace SharedMemory
@@ -16,6 +16,7 @@
 *           ノード検索               (search_nodes)
 *           ノード追加               (insert_node)
 *           ノード削除               (delete_node)
+*           (B+木の実装はIndexBTree.cc、ハッシュはIndexHash.ccを参照)
 *
 *    ３  更新履歴
 *          REV001 : 新規作成
@@ -59,7 +60,7 @@ using ::Entity::ImplIndexer;
 **//*************************************************************************/
 Index::IndexNode& Index::getNode(trid_t trid, rowid_t rowid) {
     // 参照可否チェック
-    if(!check_tuple_readable(trid, getEntry(rowid)))
+    if(!check_row_readable(trid, rowid))
         OUT_OF_RANGE("対象インデックスが参照できません"
                 "(name:" << getName() << " RowID:" << rowid <<
                 " MaxLine:" << getMaxLine() << ")");
@@ -239,6 +240,7 @@ rowid_t Index::search_nodes(rowid_vec_t& rows, const bool flag, const trid_t tri
                 if(check_tuple_writable(trid, ent) != LOCKED) {
                     // 更新できるならロックを取得する。
                     ent.lock = trid;
+                    tbl.mark_dirty(trid, rowid);
                 } else {
                     // 更新できないなら上位でタイムアウトに倒す
                     return EXECUTE_TIMEOUT;
@@ -459,7 +461,16 @@ int Index::searchNodes(rowid_vec_t& rows, const bool lockFlag,
         const ImplMatcher* idxMtcr, const ImplMatcher* dftMtcr) {
     // 全体領域の共有ロック取得
     Transaction::getTrans().getLock(Header::READ_LOCK);
-    int ret = search_nodes(rows, lockFlag, trid, root, tbl, idxMtcr, dftMtcr);
+    int ret;
+    if(index_type == INDEX_BTREE) {
+        ret = search_pages(rows, lockFlag, trid, root, tbl, idxMtcr, dftMtcr);
+        // 検索打ち切り(以降は条件より大きい)は正常終了
+        if(ret == EXECUTE_ONE) ret = EXECUTE_OK;
+    } else if(index_type == INDEX_HASH) {
+        ret = search_hash(rows, lockFlag, trid, tbl, idxMtcr, dftMtcr);
+    } else {
+        ret = search_nodes(rows, lockFlag, trid, root, tbl, idxMtcr, dftMtcr);
+    }
     Transaction::getTrans().releaseLock();
     return ret;
 }
@@ -493,7 +504,28 @@ rowid_t Index::insertNode(const trid_t trid, const rowid_t root, Entity& tbl,
         const rowid_t rowid, const ImplIndexer& idxr) {
     // 全体領域の共有ロック取得
     Transaction::getTrans().getLock(Header::READ_LOCK);
-    rowid_t ret = insert_node(trid, root, tbl, rowid, idxr);
+    rowid_t ret;
+    if(index_type == INDEX_BTREE) {
+        rowid_t split;
+        ret = insert_page(trid, root, tbl, rowid, idxr, split);
+        // ルートページが分割された場合は新しいルートを作る
+        if(ret >= 0 && split != INVALID_ROWID) {
+            rowid_t newRoot = create_page(trid, false);
+            IndexPage& pg = getPage(trid, newRoot);
+            pg.key(0) = getPage(trid, ret).key(0);
+            pg.child(0) = ret;
+            pg.key(1) = getPage(trid, split).key(0);
+            pg.child(1) = split;
+            pg.count = 2;
+            ret = newRoot;
+        }
+    } else if(index_type == INDEX_HASH) {
+        // ハッシュはルートを付け替えない
+        ret = insert_hash(trid, tbl, rowid, idxr);
+        if(ret >= 0) ret = root;
+    } else {
+        ret = insert_node(trid, root, tbl, rowid, idxr);
+    }
     Transaction::getTrans().releaseLock();
     return ret;
 }
@@ -517,7 +549,7 @@ rowid_t Index::insertNode(const trid_t trid, const rowid_t root, Entity& tbl,
 *            プラスの数         : 登録されたノード数
 *            EXECUTE_ERR       : 異常終了
 *            EXECUTE_FULL      : メモリが足りない？
-*            EXECUTE_TIMEOUT   : 上位でタイムアウトに倒す
+*            ノードを削除できない場合はtimeout例外を送出する
 *
 *    ４    履歴
 *            REV001 : 新規作成
@@ -527,8 +559,32 @@ rowid_t Index::deleteNode(const trid_t trid, const rowid_t root, Entity& tbl,
         const rowid_t rowid, const ImplIndexer& idxr) {
     // 全体領域の共有ロック取得
     Transaction::getTrans().getLock(Header::READ_LOCK);
-    rowid_t ret = delete_node(trid, root, tbl, rowid, idxr);
+    rowid_t ret;
+    if(index_type == INDEX_BTREE) {
+        ret = delete_page(trid, root, tbl, rowid, idxr);
+        // 子が1つだけになったルートページは子をルートにする
+        while(ret >= 0 && ret != INVALID_ROWID) {
+            IndexPage& pg = getPage(trid, ret);
+            if(pg.leaf || pg.count != 1) break;
+            rowid_t child = pg.child(0);
+            // 削除できない場合は上位でタイムアウトに倒す
+            rowid_t del = deleteTuple(trid, ret);
+            if(del < 0) {
+                ret = del;
+                break;
+            }
+            ret = child;
+        }
+    } else if(index_type == INDEX_HASH) {
+        // ハッシュはルートを付け替えない
+        ret = delete_hash(trid, tbl, rowid, idxr);
+        if(ret >= 0) ret = root;
+    } else {
+        ret = delete_node(trid, root, tbl, rowid, idxr);
+    }
     Transaction::getTrans().releaseLock();
+    // 途中で削除できなかった場合、ルートとして保管させない
+    if(ret == EXECUTE_TIMEOUT) TIMEOUT(getName() << " Index Delete TimeOut");
     return ret;
 }
 
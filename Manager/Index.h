@@ -21,11 +21,15 @@
 
 namespace SharedMemory
 {
+class IndexIterator;
+
 /**************************************************************************//**
 * クラス名 : 個別インデックス管理情報クラス(CSharedMemoryIndex)
 *            個別のインデックス情報を管理する。
 **//**************************************************************************/
 class Index : public Entity {
+    /// 逐次検索はノード・ページを直接辿る
+    friend class IndexIterator;
 private:
     /*----1---------2---------3---------4---------5---------6---------7---*//**
      * 構造体名 : 共通メモリ管理機能 個別インデックスノード情報定義(NODE)
@@ -41,15 +45,66 @@ private:
         virtual ~IndexNode() { };
     };
 
+    /*----1---------2---------3---------4---------5---------6---------7---*//**
+     * 構造体名 : 共通メモリ管理機能 B+木インデックスページ定義(PAGE)
+     *            リーフは対象エンティティのrowidを昇順に格納する。
+     *            内部ページは(子ページの最小rowid, 子ページ)の組を格納する。
+     *            キーはインデクサでしか比較できないため対象のrowidで持つ
+    **//*-1---------2---------3---------4---------5---------6---------7------*/
+    class alignas(CACHE_LINE) IndexPage {
+    public:
+        static const int32_t SLOT_NUM  = 62;            ///< スロット数
+        static const int32_t LEAF_MAX  = SLOT_NUM;      ///< リーフ最大格納数
+        static const int32_t INNER_MAX = SLOT_NUM / 2;  ///< 内部ページ最大子数
+
+        int32_t           count;            ///< 格納数(内部ページは子の数)
+        int32_t           leaf;             ///< リーフページなら1
+        ::Entity::rowid_t slot[SLOT_NUM];   ///< 格納領域
+
+        /// リーフ:i番目のrowid 内部:i番目の子の最小rowid
+        inline ::Entity::rowid_t& key(int32_t i) {
+            return leaf ? slot[i] : slot[i * 2];
+        }
+        /// 内部:i番目の子ページ
+        inline ::Entity::rowid_t& child(int32_t i) { return slot[i * 2 + 1]; }
+    };
+
+    /*----1---------2---------3---------4---------5---------6---------7---*//**
+     * 構造体名 : 共通メモリ管理機能 ハッシュインデックススロット定義(SLOT)
+     *            インデックス領域の要素をそのままオープンアドレス法の
+     *            バケット配列として使う。可視性は要素のエントリで判定する。
+     *            開放後もtargetを残し、未使用(INVALID_ROWID)と区別する
+    **//*-1---------2---------3---------4---------5---------6---------7------*/
+    class HashSlot {
+    public:
+        ::Entity::rowid_t target;   ///< 対象エンティティのrowid
+        uint64_t          hash;     ///< 対象タプルのハッシュ値
+    };
+
  public:
     /**********************************************************************//**
     *   関数名 : サイズ取得(getSize)
     *            フィールド数(LINE)をもとに必要なデータサイズを取得する。
-    *   引数   : num : フィールド数(LINE)                              [入力]
+    *   引数   : num    : フィールド数(LINE)                       [入力]
+    *            type   : インデックス種別                         [入力]
+    *            layout : 物理配置種別                             [入力]
     *   戻り値 : メモリサイズ(byte)
     **//*********************************************************************/
-    static inline size_t getSize(size_t num) {
-        return Entity::getSize(num, sizeof(Index::IndexNode));
+    static inline size_t getSize(size_t num, IndexType type = INDEX_TREAP,
+            LayoutType layout = LAYOUT_SPLIT) {
+        return Entity::getSize(num, getNodeSize(type), layout);
+    }
+
+    /**********************************************************************//**
+    *   関数名 : 要素サイズ取得(getNodeSize)
+    *            インデックス種別毎の要素(ノード・ページ)サイズを取得する。
+    *   引数   : type : インデックス種別                         [入力]
+    *   戻り値 : 要素サイズ(byte)
+    **//*********************************************************************/
+    static inline size_t getNodeSize(IndexType type) {
+        if(type == INDEX_BTREE) return sizeof(IndexPage);
+        if(type == INDEX_HASH) return sizeof(HashSlot);
+        return sizeof(IndexNode);
     }
 
     /**********************************************************************//**
@@ -67,10 +122,23 @@ private:
     *            個別インデックス管理領域を初期化する。
     *   引数   : name   : 領域名                             [入力]
     *            num    : フィールド数(LINE)                 [入力]
+    *            type   : インデックス種別                   [入力]
+    *            reserve: 確保済み要素数(ハッシュは無視)     [入力]
+    *            layout : 物理配置種別                       [入力]
     *   戻り値 : なし
     **//**********************************************************************/
-    inline void init(const ::std::string& name, ::Entity::rowid_t num) {
-        Entity::init(name, num, sizeof(Index::IndexNode));
+    inline void init(const ::std::string& name, ::Entity::rowid_t num,
+            IndexType type = INDEX_TREAP, size_t reserve = 0,
+            LayoutType layout = LAYOUT_SPLIT) {
+        Entity::init(name, num, getNodeSize(type), type == INDEX_HASH ? 0 : reserve,
+                layout);
+        index_type = type;
+        // ハッシュは探索が全スロットに及ぶため、全スロットを未使用にする
+        if(type == INDEX_HASH) {
+            init_slots(num);
+            for(::Entity::rowid_t i = 0; i < num; i++) getSlot(i).target =
+                    ::Entity::INVALID_ROWID;
+        }
     }
 
  private:
@@ -93,6 +161,51 @@ private:
     /// ノード削除
     ::Entity::rowid_t delete_node(const trid_t, const ::Entity::rowid_t,
             Entity&, const ::Entity::rowid_t, const ::Entity::ImplIndexer&);
+
+    /// B+木ページ取得
+    IndexPage& getPage(trid_t, ::Entity::rowid_t);
+    /// B+木ページ作成
+    ::Entity::rowid_t create_page(trid_t, bool);
+    /// B+木ページ内位置検索
+    int32_t find_slot(IndexPage&, Entity&, ::Entity::rowid_t,
+            const ::Entity::ImplIndexer&);
+    /// B+木検索
+    ::Entity::rowid_t search_pages(::Entity::rowid_vec_t&, const bool,
+            const trid_t, const ::Entity::rowid_t,
+            Entity&, const ::Entity::ImplMatcher* = nullptr,
+            const ::Entity::ImplMatcher* = nullptr);
+    /// B+木登録
+    ::Entity::rowid_t insert_page(const trid_t, const ::Entity::rowid_t,
+            Entity&, const ::Entity::rowid_t, const ::Entity::ImplIndexer&,
+            ::Entity::rowid_t&);
+    /// B+木削除
+    ::Entity::rowid_t delete_page(const trid_t, const ::Entity::rowid_t,
+            Entity&, const ::Entity::rowid_t, const ::Entity::ImplIndexer&);
+
+    /**********************************************************************//**
+    *   関数名 : ハッシュスロット取得(getSlot)
+    *            要素番号のハッシュスロットを取得する。可視判定は行わない
+    *   引数   : rowid : 要素番号                              [入力]
+    *   戻り値 : ハッシュスロットのアドレス
+    **//*********************************************************************/
+    inline HashSlot& getSlot(::Entity::rowid_t rowid) {
+        return reinterpret_cast<HashSlot&>(getTuple(rowid));
+    }
+    /// ハッシュ値取得
+    static uint64_t hash_tuple(const ::Entity::ImplIndexer&,
+            const ::Entity::AbstEntity&);
+    /// ハッシュスロット確保
+    void create_slot(trid_t, ::Entity::rowid_t, ::Entity::rowid_t, uint64_t);
+    /// ハッシュ検索
+    ::Entity::rowid_t search_hash(::Entity::rowid_vec_t&, const bool,
+            const trid_t, Entity&, const ::Entity::ImplMatcher* = nullptr,
+            const ::Entity::ImplMatcher* = nullptr);
+    /// ハッシュ登録
+    ::Entity::rowid_t insert_hash(const trid_t, Entity&, const ::Entity::rowid_t,
+            const ::Entity::ImplIndexer&);
+    /// ハッシュ削除
+    ::Entity::rowid_t delete_hash(const trid_t, Entity&, const ::Entity::rowid_t,
+            const ::Entity::ImplIndexer&);
  public:
     /// ノード検索基底
     int searchNodes(::Entity::rowid_vec_t&, const bool, trid_t,
@@ -0,0 +1,432 @@
+/**************************************************************************//**
+* @file
+*     モジュール名：個別インデックス管理情報クラス(B+木)
+* <pre>
+*
+*    １  機能
+*          個別インデックスのB+木実装。
+*          ページはインデックス領域の要素として格納し、更新はページ単位の
+*          コピーオンライト(updateTuple)で行うため、参照中のトランザクション
+*          からは更新前のページが見え続ける
+*
+*    ２  関数名一覧
+*           ページアドレス取得       (getPage)
+*           ページ作成               (create_page)
+*           ページ内位置検索         (find_slot)
+*           ページ検索               (search_pages)
+*           ページ登録               (insert_page)
+*           ページ削除               (delete_page)
+*
+*    ３  更新履歴
+*          REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+#include <Manager/Index.h>
+#include <Manager/Transaction.h>
+
+#include "inc/SHMConst.h"
+#include "inc/SHMmacro.h"
+
+namespace SharedMemory
+{
+using ::Entity::rowid_t;
+using ::Entity::INVALID_ROWID;
+using ::Entity::rowid_vec_t;
+using ::Entity::ImplMatcher;
+using ::Entity::ImplIndexer;
+
+/**************************************************************************//**
+*
+*     関数名： ページアドレス取得(getPage)
+* <pre>
+*
+*    １    機能
+*            要素番号から、可視なB+木ページのアドレスを取得する
+*
+*    ２    引数
+*            self_trid  : 自トランザクションID          [入力]
+*            rowid      : 要素番号                      [入力]
+*
+*    ３    戻り値
+*            ページのアドレス
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//*************************************************************************/
+Index::IndexPage& Index::getPage(trid_t trid, rowid_t rowid) {
+    // 参照可否チェック
+    if(!check_row_readable(trid, rowid))
+        OUT_OF_RANGE("対象インデックスが参照できません"
+                "(name:" << getName() << " RowID:" << rowid <<
+                " MaxLine:" << getMaxLine() << ")");
+    return reinterpret_cast<IndexPage&>(getTuple(rowid));
+}
+
+/**************************************************************************//**
+*
+*     関数名： ページ作成(create_page)
+* <pre>
+*
+*    １    機能
+*            空のB+木ページを作成する
+*
+*    ２    引数
+*            self_trid  : 自トランザクションID          [入力]
+*            leaf       : リーフページならtrue          [入力]
+*
+*    ３    戻り値
+*            作成したページの要素番号
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//*************************************************************************/
+rowid_t Index::create_page(trid_t trid, bool leaf) {
+    // インデックス単位で排他ロック
+    getLock(Header::WRITE_LOCK);
+    rowid_t page = createTuple(trid);
+    releaseLock();
+
+    IndexPage& pg = getPage(trid, page);
+    pg.count = 0;
+    pg.leaf = leaf ? 1 : 0;
+    return page;
+}
+
+/**************************************************************************//**
+*
+*     関数名： ページ内位置検索(find_slot)
+* <pre>
+*
+*    １    機能
+*            ページ内で、指定したタプル以上となる最初の位置を二分探索する
+*
+*    ２    引数
+*            page       : 対象ページ                    [入力]
+*            table      : テーブルエンティティ          [入力]
+*            rowid      : 対象タプルの要素番号          [入力]
+*            indexer    : インデクサ                    [入力]
+*
+*    ３    戻り値
+*            位置(0～count)
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//*************************************************************************/
+int32_t Index::find_slot(IndexPage& pg, Entity& tbl, rowid_t rowid,
+        const ImplIndexer& idxr) {
+    const ::Entity::AbstEntity& data = tbl.getTuple(rowid);
+    int32_t low = 0;
+    int32_t high = pg.count;
+    while(low < high) {
+        int32_t mid = (low + high) / 2;
+        if(idxr.compare(tbl.getTuple(pg.key(mid)), data) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/**************************************************************************//**
+*
+*     関数名： ページ検索(search_pages)
+* <pre>
+*
+*    １    機能
+*            B+木を昇順に検索する。子ページの最小値とインデックスマッチャ
+*            で、条件に一致しない子ページは読み飛ばす
+*
+*    ２    引数
+*            rowv     : 検索結果RowID格納用vector     [出力]
+*            flag     : 更新ロックフラグ              [入力]
+*            trid     : 自トランザクションID          [入力]
+*            page     : ページの要素番号              [入力]
+*            tbl      : テーブルエンティティ          [入力]
+*            idxMtcr  : インデックスマッチャ          [入力]
+*            dftMtcr  : デフォルトマッチャ            [入力]
+*
+*    ３    戻り値
+*            EXECUTE_OK        : 正常終了(後続ページも検索する)
+*            EXECUTE_ONE       : 正常終了(後続ページは条件より大きい)
+*            EXECUTE_TIMEOUT   : 上位でタイムアウトに倒す
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//*************************************************************************/
+rowid_t Index::search_pages(rowid_vec_t& rows, const bool flag, const trid_t trid,
+        const rowid_t cPage, Entity& tbl, const ImplMatcher* idxMtcr,
+        const ImplMatcher* dftMtcr) {
+    // 引数チェック
+    if(cPage == INVALID_ROWID) return EXECUTE_OK;
+    if(cPage < 0) return cPage;
+    IndexPage& pg = getPage(trid, cPage);
+
+    if(!pg.leaf) {
+        for(int32_t i = 0; i < pg.count; i++) {
+            if(idxMtcr != nullptr) {
+                // 次の子の最小値が条件より小さければ、この子は全て条件より小さい
+                if(i + 1 < pg.count &&
+                        idxMtcr->match(tbl.getTuple(pg.key(i + 1))) < 0) continue;
+                // この子の最小値が条件より大きければ、以降は全て条件より大きい
+                if(idxMtcr->match(tbl.getTuple(pg.key(i))) > 0) return EXECUTE_ONE;
+            }
+            rowid_t ret = search_pages(rows, flag, trid, pg.child(i), tbl,
+                    idxMtcr, dftMtcr);
+            if(ret != EXECUTE_OK) return ret;
+        }
+        return EXECUTE_OK;
+    }
+
+    for(int32_t i = 0; i < pg.count; i++) {
+        rowid_t rowid = pg.key(i);
+        const ::Entity::AbstEntity& data = tbl.getTuple(rowid);
+        // インデックスマッチャ実行
+        int m = idxMtcr != nullptr ? idxMtcr->match(data) : 0;
+        if(m < 0) continue;
+        if(m > 0) return EXECUTE_ONE;
+        // 一致の場合、デフォルトマッチャ実行
+        if(dftMtcr != nullptr && dftMtcr->match(data) != 0) continue;
+
+        // 更新ロックフラグONなら
+        if(flag) {
+            // 対象エントリの更新ロック取得可否を調べる
+            Entry& ent = tbl.getEntry(rowid);
+            if(check_tuple_writable(trid, ent) == LOCKED) {
+                // 更新できないなら上位でタイムアウトに倒す
+                return EXECUTE_TIMEOUT;
+            }
+            // 更新できるならロックを取得する。
+            ent.lock = trid;
+            tbl.mark_dirty(trid, rowid);
+        }
+        // RowIDをvecterに登録
+        rows.push_back(rowid);
+    }
+    return EXECUTE_OK;
+}
+
+/**************************************************************************//**
+*
+*     関数名： ページ登録(insert_page)
+* <pre>
+*
+*    １    機能
+*            B+木にタプルを登録する。経路上のページはコピーオンライトで
+*            更新し、溢れたページは分割して右側のページを返す
+*
+*    ２    引数
+*            self_trid  : 自トランザクションID           [入力]
+*            page       : 起点となるページ               [入力]
+*            table      : テーブルエンティティ           [入力]
+*            rowid      : 登録するタプル                 [入力]
+*            indexer    : インデクサ                     [入力]
+*            split      : 分割した右側のページ           [出力]
+*                         (分割しない場合はINVALID_ROWID)
+*
+*    ３    戻り値
+*            プラスの数        : 登録後のページ
+*            EXECUTE_KEYERR    : 同一のタプルが登録済み
+*            EXECUTE_TIMEOUT   : 上位でタイムアウトに倒す
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//*************************************************************************/
+rowid_t Index::insert_page(const trid_t trid, const rowid_t cPage, Entity& tbl,
+        const rowid_t rowid, const ImplIndexer& idxr, rowid_t& split) {
+    // 引数チェック
+    if(rowid < 0) INVALID_ARGUMENT("RowIDが無効です");
+    split = INVALID_ROWID;
+
+    if(cPage < 0 || cPage == INVALID_ROWID) {
+        // インデックスがない場合、新しいリーフを作成
+        rowid_t newPage = create_page(trid, true);
+        IndexPage& pg = getPage(trid, newPage);
+        pg.key(0) = rowid;
+        pg.count = 1;
+        SHM_DEBUG_DMP(INS_NODE, getName().c_str(), newPage, &pg, sizeof(pg));
+        return newPage;
+    }
+
+    IndexPage& org = getPage(trid, cPage);
+    int32_t pos = find_slot(org, tbl, rowid, idxr);
+
+    // 格納する(キー,子ページ)の組。リーフは子ページを使わない
+    rowid_t key = rowid;
+    rowid_t child = INVALID_ROWID;
+    rowid_t newPage;
+    if(org.leaf) {
+        if(pos < org.count &&
+                idxr.compare(tbl.getTuple(org.key(pos)), tbl.getTuple(rowid)) == 0) {
+            // 同一の値が存在する場合
+            SHM_WARN_LOG("同じタプルが指定されています。");
+            return EXECUTE_KEYERR;
+        }
+        // いまのページをコピーして新しいページを作る
+        newPage = updateTuple(trid, cPage);
+        if(newPage < 0) return newPage;
+    } else {
+        // 最小値より小さい場合は先頭の子、それ以外は直前の子へ登録する
+        int32_t ci = pos;
+        if(ci == org.count || idxr.compare(tbl.getTuple(org.key(ci)),
+                tbl.getTuple(rowid)) != 0) ci = ci > 0 ? ci - 1 : 0;
+
+        rowid_t childSplit;
+        rowid_t newChild = insert_page(trid, org.child(ci), tbl, rowid, idxr,
+                childSplit);
+        if(newChild < 0) return newChild;
+
+        // いまのページをコピーして子ページを差し替える
+        newPage = updateTuple(trid, cPage);
+        if(newPage < 0) return newPage;
+        IndexPage& pg = getPage(trid, newPage);
+        pg.child(ci) = newChild;
+        pg.key(ci) = getPage(trid, newChild).key(0);
+        if(childSplit == INVALID_ROWID) return newPage;
+
+        // 子ページが分割された場合は右側の子を追加する
+        pos = ci + 1;
+        key = getPage(trid, childSplit).key(0);
+        child = childSplit;
+    }
+
+    IndexPage& pg = getPage(trid, newPage);
+
+    const int32_t max = pg.leaf ? IndexPage::LEAF_MAX : IndexPage::INNER_MAX;
+    if(pg.count < max) {
+        // 空きがあればずらして格納する
+        for(int32_t i = pg.count; i > pos; i--) {
+            pg.key(i) = pg.key(i - 1);
+            if(!pg.leaf) pg.child(i) = pg.child(i - 1);
+        }
+        pg.key(pos) = key;
+        if(!pg.leaf) pg.child(pos) = child;
+        pg.count++;
+        SHM_DEBUG_DMP(INS_NODE, getName().c_str(), newPage, &pg, sizeof(pg));
+        return newPage;
+    }
+
+    // 溢れる場合は半分を新しい右側のページへ移す
+    rowid_t keys[IndexPage::SLOT_NUM + 1];
+    rowid_t childs[IndexPage::SLOT_NUM + 1];
+    for(int32_t i = 0, j = 0; i <= pg.count; i++) {
+        if(i == pos) {
+            keys[i] = key;
+            childs[i] = child;
+        } else {
+            keys[i] = pg.key(j);
+            childs[i] = pg.leaf ? INVALID_ROWID : pg.child(j);
+            j++;
+        }
+    }
+    const int32_t total = pg.count + 1;
+    const int32_t half = total / 2;
+
+    split = create_page(trid, pg.leaf != 0);
+    IndexPage& right = getPage(trid, split);
+    for(int32_t i = half; i < total; i++) {
+        right.key(i - half) = keys[i];
+        if(!right.leaf) right.child(i - half) = childs[i];
+    }
+    right.count = total - half;
+    for(int32_t i = 0; i < half; i++) {
+        pg.key(i) = keys[i];
+        if(!pg.leaf) pg.child(i) = childs[i];
+    }
+    pg.count = half;
+
+    SHM_DEBUG_DMP(INS_NODE, getName().c_str(), newPage, &pg, sizeof(pg));
+    SHM_DEBUG_DMP(INS_NODE, getName().c_str(), split, &right, sizeof(right));
+    return newPage;
+}
+
+/**************************************************************************//**
+*
+*     関数名： ページ削除(delete_page)
+* <pre>
+*
+*    １    機能
+*            B+木からタプルを削除する。経路上のページはコピーオンライトで
+*            更新し、空になったページは削除する。
+*            親ページのキーは子ページの最小値に合わせて更新する
+*
+*    ２    引数
+*            self_trid  : 自トランザクションID           [入力]
+*            page       : 起点となるページ               [入力]
+*            table      : テーブルエンティティ           [入力]
+*            rowid      : 削除するタプル                 [入力]
+*            indexer    : インデクサ                     [入力]
+*
+*    ３    戻り値
+*            プラスの数        : 削除後のページ
+*            INVALID_ROWID     : ページが空になった
+*            EXECUTE_TIMEOUT   : 上位でタイムアウトに倒す
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//*************************************************************************/
+rowid_t Index::delete_page(const trid_t trid, const rowid_t cPage, Entity& tbl,
+        const rowid_t rowid, const ImplIndexer& idxr) {
+    // 引数チェック
+    if(rowid < 0) INVALID_ARGUMENT("RowIDが無効です");
+    if(cPage < 0) return cPage;
+
+    IndexPage& org = getPage(trid, cPage);
+    int32_t pos = find_slot(org, tbl, rowid, idxr);
+    bool found = pos < org.count &&
+            idxr.compare(tbl.getTuple(org.key(pos)), tbl.getTuple(rowid)) == 0;
+
+    if(org.leaf) {
+        // 見つからない場合は変更しない
+        if(!found) return cPage;
+        SHM_DEBUG_DMP(DEL_NODE, getName().c_str(), rowid, &org, sizeof(org));
+        // 最後の1件ならページごと削除する
+        if(org.count == 1) {
+            rowid_t ret = deleteTuple(trid, cPage);
+            if(ret < 0) return ret;
+            return INVALID_ROWID;
+        }
+        rowid_t newPage = updateTuple(trid, cPage);
+        if(newPage < 0) return newPage;
+        IndexPage& pg = getPage(trid, newPage);
+        for(int32_t i = pos; i < pg.count - 1; i++) pg.key(i) = pg.key(i + 1);
+        pg.count--;
+        return newPage;
+    }
+
+    // 対象を含む子ページ
+    int32_t ci = found ? pos : (pos > 0 ? pos - 1 : 0);
+    rowid_t newChild = delete_page(trid, org.child(ci), tbl, rowid, idxr);
+    if(newChild < 0 && newChild != INVALID_ROWID) return newChild;
+
+    rowid_t newPage = updateTuple(trid, cPage);
+    if(newPage < 0) return newPage;
+    IndexPage& pg = getPage(trid, newPage);
+    if(newChild != INVALID_ROWID) {
+        // 子ページを差し替え、キーを子ページの最小値に合わせる
+        pg.child(ci) = newChild;
+        pg.key(ci) = getPage(trid, newChild).key(0);
+        return newPage;
+    }
+
+    // 子ページが空になった場合は取り除く
+    for(int32_t i = ci; i < pg.count - 1; i++) {
+        pg.key(i) = pg.key(i + 1);
+        pg.child(i) = pg.child(i + 1);
+    }
+    pg.count--;
+    if(pg.count > 0) return newPage;
+
+    rowid_t ret = deleteTuple(trid, newPage);
+    if(ret < 0) return ret;
+    return INVALID_ROWID;
+}
+
+/*--------1---------2---------3---------4---------5---------6---------7------*/
+}    // SharedMemory
@@ -0,0 +1,300 @@
+/**************************************************************************//**
+* @file
+*     モジュール名：個別インデックス管理情報クラス(ハッシュ)
+* <pre>
+*
+*    １  機能
+*          個別インデックスのハッシュ実装。
+*          インデックス領域の要素をオープンアドレス法(線形探索)のバケット
+*          配列として使い、スロット毎のエントリ(xmin/xmax)で可視判定する。
+*          木構造のようにルートを付け替えないため、インデックスルートは
+*          更新しない。一致検索専用で、範囲検索は全件走査となる
+*
+*    ２  関数名一覧
+*           ハッシュ値取得           (hash_tuple)
+*           ハッシュスロット確保     (create_slot)
+*           ハッシュ検索             (search_hash)
+*           ハッシュ登録             (insert_hash)
+*           ハッシュ削除             (delete_hash)
+*
+*    ３  更新履歴
+*          REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+#include <Manager/HashIndexer.h>
+#include <Manager/Index.h>
+#include <Manager/Transaction.h>
+
+#include "inc/SHMConst.h"
+#include "inc/SHMmacro.h"
+
+namespace SharedMemory
+{
+using ::Entity::AbstEntity;
+using ::Entity::rowid_t;
+using ::Entity::INVALID_ROWID;
+using ::Entity::rowid_vec_t;
+using ::Entity::ImplMatcher;
+using ::Entity::ImplIndexer;
+
+/**************************************************************************//**
+*
+*     関数名： ハッシュ値取得(hash_tuple)
+* <pre>
+*
+*    １    機能
+*            インデクサからタプルのハッシュ値を取得する
+*
+*    ２    引数
+*            indexer    : インデクサ(HashIndexerであること) [入力]
+*            data       : 対象タプル                        [入力]
+*
+*    ３    戻り値
+*            ハッシュ値
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//*************************************************************************/
+uint64_t Index::hash_tuple(const ImplIndexer& idxr, const AbstEntity& data) {
+    const HashIndexer* hidxr = dynamic_cast<const HashIndexer*>(&idxr);
+    if(hidxr == nullptr)
+        INVALID_ARGUMENT("ハッシュインデックスのインデクサがHashIndexerでは"
+                "ありません");
+    return hidxr->hash(data);
+}
+
+/**************************************************************************//**
+*
+*     関数名： ハッシュスロット確保(create_slot)
+* <pre>
+*
+*    １    機能
+*            空きのハッシュスロットを自トランザクションで確保する。
+*            インデックス単位の排他ロック中に呼び出すこと
+*
+*    ２    引数
+*            self_trid  : 自トランザクションID          [入力]
+*            pos        : スロットの要素番号            [入力]
+*            rowid      : 対象タプルの要素番号          [入力]
+*            hash       : 対象タプルのハッシュ値        [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//*************************************************************************/
+void Index::create_slot(trid_t trid, rowid_t pos, rowid_t rowid, uint64_t hash) {
+    HashSlot& slot = getSlot(pos);
+    slot.target = rowid;
+    slot.hash = hash;
+
+    Entry& ent = getEntry(pos);
+    clear_all_visible(pos);
+    mark_dirty(trid, pos);
+    ent.xmax = TRID_MAX;
+    ent.lock = TRID_MAX;
+    ent.xmin = trid;
+
+    mark_used_slot(pos);
+    if(used_end < pos + 1) used_end = pos + 1;
+    // 最新の空きエントリを設定
+    free_begin = find_free_slot();
+    if(free_begin == INVALID_ROWID) free_begin = init_end;
+}
+
+/**************************************************************************//**
+*
+*     関数名： ハッシュ検索(search_hash)
+* <pre>
+*
+*    １    機能
+*            インデックスマッチャがHashMatcherなら、検索値のハッシュ値の
+*            スロットから未使用スロットまでを探索する。
+*            それ以外は全スロットを走査する。結果の順序は不定
+*
+*    ２    引数
+*            rowv     : 検索結果RowID格納用vector     [出力]
+*            flag     : 更新ロックフラグ              [入力]
+*            trid     : 自トランザクションID          [入力]
+*            tbl      : テーブルエンティティ          [入力]
+*            idxMtcr  : インデックスマッチャ          [入力]
+*            dftMtcr  : デフォルトマッチャ            [入力]
+*
+*    ３    戻り値
+*            EXECUTE_OK        : 正常終了
+*            EXECUTE_TIMEOUT   : 上位でタイムアウトに倒す
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//*************************************************************************/
+rowid_t Index::search_hash(rowid_vec_t& rows, const bool flag, const trid_t trid,
+        Entity& tbl, const ImplMatcher* idxMtcr, const ImplMatcher* dftMtcr) {
+    const rowid_t max = static_cast<rowid_t>(getMaxLine());
+    const HashMatcher* hmtcr = dynamic_cast<const HashMatcher*>(idxMtcr);
+    const uint64_t hash = hmtcr != nullptr ? hmtcr->hash() : 0;
+
+    for(rowid_t n = 0; n < max; n++) {
+        rowid_t pos = hmtcr != nullptr ? static_cast<rowid_t>((hash + n) % max) : n;
+        if(hmtcr == nullptr && pos >= used_end) break;
+        Entry& ent = getEntry(pos);
+        const HashSlot& slot = getSlot(pos);
+        // 未使用スロットで探索終了
+        if(ent.xmin == TRID_MAX) {
+            if(hmtcr != nullptr && slot.target == INVALID_ROWID) break;
+            continue;
+        }
+        if(hmtcr != nullptr && slot.hash != hash) continue;
+        if(!check_row_readable(trid, pos)) continue;
+
+        rowid_t rowid = slot.target;
+        const AbstEntity& data = tbl.getTuple(rowid);
+        // ハッシュ値の衝突はインデックスマッチャで除く
+        if(idxMtcr != nullptr && idxMtcr->match(data) != 0) continue;
+        if(dftMtcr != nullptr && dftMtcr->match(data) != 0) continue;
+
+        // 更新ロックフラグONなら
+        if(flag) {
+            // 対象エントリの更新ロック取得可否を調べる
+            Entry& tent = tbl.getEntry(rowid);
+            if(check_tuple_writable(trid, tent) == LOCKED) {
+                // 更新できないなら上位でタイムアウトに倒す
+                return EXECUTE_TIMEOUT;
+            }
+            // 更新できるならロックを取得する。
+            tent.lock = trid;
+            tbl.mark_dirty(trid, rowid);
+        }
+        // RowIDをvecterに登録
+        rows.push_back(rowid);
+    }
+    return EXECUTE_OK;
+}
+
+/**************************************************************************//**
+*
+*     関数名： ハッシュ登録(insert_hash)
+* <pre>
+*
+*    １    機能
+*            タプルのハッシュ値のスロットから探索し、同じ値が存在すれば
+*            キー重複とする。自Trから不可視でも、他Trが登録中または自Tr
+*            開始後にコミットしたスロットは存在するものとする。
+*            最初の空きスロット(開放済みを含む)に登録する
+*
+*    ２    引数
+*            self_trid  : 自トランザクションID           [入力]
+*            table      : テーブルエンティティ           [入力]
+*            rowid      : 登録するタプル                 [入力]
+*            indexer    : インデクサ                     [入力]
+*
+*    ３    戻り値
+*            EXECUTE_OK        : 正常終了
+*            EXECUTE_KEYERR    : 同一のタプルが登録済み
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//*************************************************************************/
+rowid_t Index::insert_hash(const trid_t trid, Entity& tbl, const rowid_t rowid,
+        const ImplIndexer& idxr) {
+    // 引数チェック
+    if(rowid < 0) INVALID_ARGUMENT("RowIDが無効です");
+    const rowid_t max = static_cast<rowid_t>(getMaxLine());
+    const AbstEntity& data = tbl.getTuple(rowid);
+    const uint64_t hash = hash_tuple(idxr, data);
+
+    // インデックス単位で排他ロック
+    getLock(Header::WRITE_LOCK);
+    rowid_t free = INVALID_ROWID;
+    for(rowid_t n = 0; n < max; n++) {
+        rowid_t pos = static_cast<rowid_t>((hash + n) % max);
+        Entry& ent = getEntry(pos);
+        const HashSlot& slot = getSlot(pos);
+        if(ent.xmin == TRID_MAX) {
+            if(free == INVALID_ROWID) free = pos;
+            // 未使用スロット以降に同じハッシュ値はない
+            if(slot.target == INVALID_ROWID) break;
+            continue;
+        }
+        if(slot.hash != hash) continue;
+        if(!check_row_readable(trid, pos)) {
+            // 自Trから不可視でも、他Trが登録中・自Tr開始後にコミット済みなら
+            // 同じ値が存在するとみなす(アボート済み・削除済みは除く)
+            const trid_t xmax = ent.getXmax();
+            if(xmax == trid) continue;
+            if(!Transaction::is_tr_valid_to_write(trid, ent.getXmin(),
+                    Transaction::IS_XMAX)) continue;
+            if(!Transaction::is_tr_valid_to_write(trid, xmax, Transaction::IS_LOCK)
+                    && Transaction::is_tr_valid_to_write(trid, xmax,
+                    Transaction::IS_XMAX)) continue;
+        }
+        if(idxr.compare(tbl.getTuple(slot.target), data) == 0) {
+            releaseLock();
+            // 同一の値が存在する場合
+            SHM_WARN_LOG("同じタプルが指定されています。");
+            return EXECUTE_KEYERR;
+        }
+    }
+    if(free == INVALID_ROWID) {
+        releaseLock();
+        MEMORYFULL("メモリフル:" << getName());
+    }
+    create_slot(trid, free, rowid, hash);
+    releaseLock();
+
+    SHM_DEBUG_DMP(INS_NODE, getName().c_str(), free, &getSlot(free),
+            sizeof(HashSlot));
+    return EXECUTE_OK;
+}
+
+/**************************************************************************//**
+*
+*     関数名： ハッシュ削除(delete_hash)
+* <pre>
+*
+*    １    機能
+*            タプルを指す可視なスロットを探し、論理削除する
+*
+*    ２    引数
+*            self_trid  : 自トランザクションID           [入力]
+*            table      : テーブルエンティティ           [入力]
+*            rowid      : 削除するタプル                 [入力]
+*            indexer    : インデクサ                     [入力]
+*
+*    ３    戻り値
+*            EXECUTE_OK        : 正常終了(対象なしを含む)
+*            EXECUTE_TIMEOUT   : 上位でタイムアウトに倒す
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//*************************************************************************/
+rowid_t Index::delete_hash(const trid_t trid, Entity& tbl, const rowid_t rowid,
+        const ImplIndexer& idxr) {
+    // 引数チェック
+    if(rowid < 0) INVALID_ARGUMENT("RowIDが無効です");
+    const rowid_t max = static_cast<rowid_t>(getMaxLine());
+    const uint64_t hash = hash_tuple(idxr, tbl.getTuple(rowid));
+
+    for(rowid_t n = 0; n < max; n++) {
+        rowid_t pos = static_cast<rowid_t>((hash + n) % max);
+        Entry& ent = getEntry(pos);
+        const HashSlot& slot = getSlot(pos);
+        if(ent.xmin == TRID_MAX) {
+            if(slot.target == INVALID_ROWID) break;
+            continue;
+        }
+        if(slot.target != rowid || !check_row_readable(trid, pos)) continue;
+
+        SHM_DEBUG_DMP(DEL_NODE, getName().c_str(), pos, &slot, sizeof(slot));
+        return deleteTuple(trid, pos);
+    }
+    return EXECUTE_OK;
+}
+
+/*--------1---------2---------3---------4---------5---------6---------7------*/
+}    // SharedMemory
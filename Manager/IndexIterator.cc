@@ -0,0 +1,391 @@
+/**************************************************************************//**
+* @file
+*     モジュール名：共通メモリ管理機能 インデックス逐次検索クラス
+* <pre>
+*
+*    １  機能
+*          インデックスをフェッチ毎に1件ずつ辿る逐次検索クラス
+*
+*    ２  関数名一覧
+*           コンストラクタ           (IndexIterator)
+*           次の一致タプル取得       (next)
+*           トリープ左端までの下降   (descend_node)
+*           トリープ逐次検索         (next_node)
+*           B+木逐次検索             (next_page)
+*           ハッシュ逐次検索         (next_hash)
+*           全件逐次検索             (next_scan)
+*           タプル判定               (check_tuple)
+*
+*    ３  更新履歴
+*          REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+#include <Manager/IndexIterator.h>
+
+#include "inc/SHMConst.h"
+#include "inc/SHMmacro.h"
+
+namespace SharedMemory
+{
+using ::Entity::AbstEntity;
+using ::Entity::rowid_t;
+using ::Entity::INVALID_ROWID;
+using ::Entity::ImplMatcher;
+
+/**************************************************************************//**
+*
+*     関数名：コンストラクタ (IndexIterator)
+* <pre>
+*
+*    １    機能
+*            走査位置をルートの左端(インデックスなしは先頭)に設定する
+*
+*    ２    引数
+*            trid     : 自トランザクションID          [入力]
+*            flag     : 更新ロックフラグ              [入力]
+*            tbl      : テーブルエンティティ          [入力]
+*            index    : インデックス(なしはnullptr)   [入力]
+*            root     : インデックスルート            [入力]
+*            idxMtcr  : インデックスマッチャ          [入力]
+*            dftMtcr  : デフォルトマッチャ            [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+IndexIterator::IndexIterator(const trid_t trid, const bool flag, Entity& tbl,
+        Index* index, const rowid_t root, const ImplMatcher* idxMtcr,
+        const ImplMatcher* dftMtcr) : trid(trid), snapshot(trid), flag(flag), table(tbl),
+        index(index), idx_mtcr(idxMtcr), dft_mtcr(dftMtcr), scan(0),
+        hash_mtcr(dynamic_cast<const HashMatcher*>(idxMtcr)) {
+    // ハッシュはルートを持たない
+    if(index == nullptr || index->index_type == INDEX_HASH || root < 0) return;
+
+    Snapshot::Scope scope(snapshot);
+    // ルートはオープン時点で可視であること
+    if(!index->check_row_readable(trid, root))
+        OUT_OF_RANGE("対象インデックスが参照できません"
+                "(name:" << index->getName() << " RowID:" << root << ")");
+
+    Transaction::getTrans().getLock(Header::READ_LOCK);
+    if(index->index_type == INDEX_BTREE) {
+        stack.push_back(Frame{root, 0});
+    } else {
+        descend_node(root);
+    }
+    Transaction::getTrans().releaseLock();
+}
+
+/**************************************************************************//**
+*
+*     関数名：次の一致タプル取得 (next)
+* <pre>
+*
+*    １    機能
+*            走査位置を次の一致タプルまで進め、その要素番号を返す。
+*            更新ロックが取得できない場合は走査位置を進めずに返すため、
+*            待ち合わせ後に再度呼び出せば同じタプルから再開する
+*
+*    ２    引数
+*            なし
+*
+*    ３    戻り値
+*            0以上             : 一致したタプルの要素番号
+*            INVALID_ROWID     : 走査終了
+*            EXECUTE_TIMEOUT   : 更新ロック取得不可
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+rowid_t IndexIterator::next() {
+    Snapshot::Scope scope(snapshot);
+    // 全体領域の共有ロック取得
+    Transaction::getTrans().getLock(Header::READ_LOCK);
+    rowid_t ret;
+    if(index == nullptr) {
+        ret = next_scan();
+    } else if(index->index_type == INDEX_BTREE) {
+        ret = next_page();
+    } else if(index->index_type == INDEX_HASH) {
+        ret = next_hash();
+    } else {
+        ret = next_node();
+    }
+    Transaction::getTrans().releaseLock();
+    return ret;
+}
+
+/**************************************************************************//**
+*
+*     関数名：トリープ左端までの下降 (descend_node)
+* <pre>
+*
+*    １    機能
+*            指定ノードから条件以上となる左端まで下降し、経路をスタックに
+*            積む。条件より小さいノードは自身と左側を読み飛ばす
+*
+*    ２    引数
+*            cNode    : 起点となるノード              [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void IndexIterator::descend_node(rowid_t cNode) {
+    while(cNode >= 0 && cNode != INVALID_ROWID) {
+        const Index::IndexNode& node =
+                static_cast<Index::IndexNode&>(index->getTuple(cNode));
+        int i = 0;
+        if(idx_mtcr != nullptr) i = idx_mtcr->match(table.getTuple(node.index));
+        // 小さい場合は右側のみ探索
+        if(i < 0) {
+            cNode = node.right;
+            continue;
+        }
+        stack.push_back(Frame{cNode, i});
+        cNode = node.left;
+    }
+}
+
+/**************************************************************************//**
+*
+*     関数名：トリープ逐次検索 (next_node)
+* <pre>
+*
+*    １    機能
+*            スタック先頭のノード(左側は処理済み)から中間順に次の一致
+*            タプルを探す
+*
+*    ２    引数
+*            なし
+*
+*    ３    戻り値
+*            0以上             : 一致したタプルの要素番号
+*            INVALID_ROWID     : 走査終了
+*            EXECUTE_TIMEOUT   : 更新ロック取得不可
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+rowid_t IndexIterator::next_node() {
+    while(!stack.empty()) {
+        const Frame f = stack.back();
+        const Index::IndexNode& node =
+                static_cast<Index::IndexNode&>(index->getTuple(f.pos));
+        // 大きい場合は自身と右側は条件外
+        if(f.slot > 0) {
+            stack.pop_back();
+            continue;
+        }
+        // 一致の場合はデフォルトマッチャ・更新ロックを判定
+        int ret = check_tuple(node.index);
+        if(ret == EXECUTE_TIMEOUT) return ret;
+        // 右側へ進めてから返す
+        stack.pop_back();
+        descend_node(node.right);
+        if(ret == EXECUTE_OK) return node.index;
+    }
+    return INVALID_ROWID;
+}
+
+/**************************************************************************//**
+*
+*     関数名：B+木逐次検索 (next_page)
+* <pre>
+*
+*    １    機能
+*            スタック先頭のページの次のスロットから次の一致タプルを探す。
+*            内部ページはsearch_pagesと同様に条件外の子ページを読み飛ばす
+*
+*    ２    引数
+*            なし
+*
+*    ３    戻り値
+*            0以上             : 一致したタプルの要素番号
+*            INVALID_ROWID     : 走査終了
+*            EXECUTE_TIMEOUT   : 更新ロック取得不可
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+rowid_t IndexIterator::next_page() {
+    while(!stack.empty()) {
+        Frame& f = stack.back();
+        Index::IndexPage& pg =
+                reinterpret_cast<Index::IndexPage&>(index->getTuple(f.pos));
+        if(f.slot >= pg.count) {
+            stack.pop_back();
+            continue;
+        }
+        const int32_t i = f.slot;
+
+        if(!pg.leaf) {
+            f.slot++;
+            rowid_t child = pg.child(i);
+            if(idx_mtcr != nullptr) {
+                // 次の子の最小値が条件より小さければ、この子は全て条件より小さい
+                if(i + 1 < pg.count &&
+                        idx_mtcr->match(table.getTuple(pg.key(i + 1))) < 0) continue;
+                // この子の最小値が条件より大きければ、以降は全て条件より大きい
+                if(idx_mtcr->match(table.getTuple(pg.key(i))) > 0) break;
+            }
+            // push_backでfは無効になるため最後に積む
+            stack.push_back(Frame{child, 0});
+            continue;
+        }
+
+        rowid_t rowid = pg.key(i);
+        int m = idx_mtcr != nullptr ? idx_mtcr->match(table.getTuple(rowid)) : 0;
+        if(m > 0) break;
+        if(m == 0) {
+            int ret = check_tuple(rowid);
+            if(ret == EXECUTE_TIMEOUT) return ret;
+            f.slot++;
+            if(ret == EXECUTE_OK) return rowid;
+        } else {
+            f.slot++;
+        }
+    }
+    // 条件より大きくなったら以降は走査しない
+    stack.clear();
+    return INVALID_ROWID;
+}
+
+/**************************************************************************//**
+*
+*     関数名：ハッシュ逐次検索 (next_hash)
+* <pre>
+*
+*    １    機能
+*            インデックスマッチャがHashMatcherなら、検索値のハッシュ値の
+*            スロットから未使用スロットまでを、それ以外は全スロットを
+*            順に探索し、次の一致タプルを探す
+*
+*    ２    引数
+*            なし
+*
+*    ３    戻り値
+*            0以上             : 一致したタプルの要素番号
+*            INVALID_ROWID     : 走査終了
+*            EXECUTE_TIMEOUT   : 更新ロック取得不可
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//*************************************************************************/
+rowid_t IndexIterator::next_hash() {
+    const rowid_t max = static_cast<rowid_t>(index->getMaxLine());
+    const uint64_t hash = hash_mtcr != nullptr ? hash_mtcr->hash() : 0;
+
+    for(; scan < max; scan++) {
+        rowid_t pos = hash_mtcr != nullptr ?
+                static_cast<rowid_t>((hash + scan) % max) : scan;
+        if(hash_mtcr == nullptr && pos >= index->used_end) break;
+        Entity::Entry& ent = index->getEntry(pos);
+        const Index::HashSlot& slot = index->getSlot(pos);
+        // 未使用スロットで探索終了
+        if(ent.xmin == TRID_MAX) {
+            if(hash_mtcr != nullptr && slot.target == INVALID_ROWID) break;
+            continue;
+        }
+        if(hash_mtcr != nullptr && slot.hash != hash) continue;
+        if(!index->check_row_readable(trid, pos)) continue;
+        // ハッシュ値の衝突はインデックスマッチャで除く
+        if(idx_mtcr != nullptr && idx_mtcr->match(table.getTuple(slot.target)) != 0)
+            continue;
+        int ret = check_tuple(slot.target);
+        if(ret == EXECUTE_TIMEOUT) return ret;
+        if(ret == EXECUTE_OK) {
+            scan++;
+            return slot.target;
+        }
+    }
+    scan = max;
+    return INVALID_ROWID;
+}
+
+/**************************************************************************//**
+*
+*     関数名：全件逐次検索 (next_scan)
+* <pre>
+*
+*    １    機能
+*            インデックスがない場合に、エンティティを走査位置から順に
+*            可視判定し、次の一致タプルを探す
+*
+*    ２    引数
+*            なし
+*
+*    ３    戻り値
+*            0以上             : 一致したタプルの要素番号
+*            INVALID_ROWID     : 走査終了
+*            EXECUTE_TIMEOUT   : 更新ロック取得不可
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+rowid_t IndexIterator::next_scan() {
+    for(; scan < table.used_end; scan++) {
+        // エントリの可視判定
+        if(!table.check_row_readable(trid, scan)) continue;
+        int ret = check_tuple(scan);
+        if(ret == EXECUTE_TIMEOUT) return ret;
+        if(ret == EXECUTE_OK) return scan++;
+    }
+    return INVALID_ROWID;
+}
+
+/**************************************************************************//**
+*
+*     関数名：タプル判定 (check_tuple)
+* <pre>
+*
+*    １    機能
+*            デフォルトマッチャを実行し、一致した場合は更新ロックフラグに
+*            従って更新ロックを取得する
+*
+*    ２    引数
+*            rowid    : 対象タプルの要素番号          [入力]
+*
+*    ３    戻り値
+*            EXECUTE_OK        : 一致
+*            EXECUTE_NULL      : 不一致
+*            EXECUTE_TIMEOUT   : 更新ロック取得不可
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+int IndexIterator::check_tuple(rowid_t rowid) {
+    const AbstEntity& data = table.getTuple(rowid);
+    if(dft_mtcr != nullptr && dft_mtcr->match(data) != 0) return EXECUTE_NULL;
+    if(!flag) return EXECUTE_OK;
+
+    // エンティティ単位で排他ロック
+    table.getLock(Header::WRITE_LOCK);
+    Entity::Entry& ent = table.getEntry(rowid);
+    int ret = EXECUTE_OK;
+    if(Entity::check_tuple_writable(trid, ent) == Entity::LOCKED) {
+        // 更新できないなら上位で待ち合わせる
+        ret = EXECUTE_TIMEOUT;
+    } else {
+        // 更新できるならロックを取得する。
+        ent.lock = trid;
+        table.mark_dirty(trid, rowid);
+    }
+    table.releaseLock();
+    return ret;
+}
+
+/*--------1---------2---------3---------4---------5---------6---------7------*/
+}  // end namespace SharedMemory
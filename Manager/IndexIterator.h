@@ -0,0 +1,95 @@
+/**************************************************************************//**
+* @file
+*     モジュール名：共通メモリ管理機能 インデックス逐次検索クラスヘッダ
+* <pre>
+*
+*    １  機能
+*          インデックスを検索結果のvectorに展開せず、フェッチ毎に1件ずつ
+*          辿るための逐次検索クラスを定義する
+*
+*    ２  更新履歴
+*          REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+#ifndef SHAREDMEMORY_INDEXITERATOR_H_
+#define SHAREDMEMORY_INDEXITERATOR_H_
+
+#include <Entity/ImplMatcher.h>
+#include <Manager/Entity.h>
+#include <Manager/HashIndexer.h>
+#include <Manager/Index.h>
+#include <Manager/Snapshot.h>
+#include <Manager/Transaction.h>
+
+#include <vector>
+
+#include "inc/SHMConst.h"
+
+namespace SharedMemory
+{
+/**************************************************************************//**
+* クラス名 : インデックス逐次検索クラス(IndexIterator)
+* <pre>
+*          インデックスの走査位置を明示的なスタックで保持し、next()の呼出
+*          毎に次の一致タプルまで進める。保持するのは木の深さ分の位置のみ。
+*          ルートはオープン時点のものを使い、ルートから辿れるノード・ページ
+*          はコピーオンライトで書き換わらず、自Trが終わるまでGCで回収され
+*          ないため、オープン時点の版をそのまま辿る。
+*          可視判定はオープン時に作成したスナップショットで行う。
+*          ハッシュは探索位置を、インデックスがない場合はエンティティを
+*          先頭から走査する。
+*          マッチャはイテレータを破棄するまで呼出し元で保持すること
+* </pre>
+**//**************************************************************************/
+class IndexIterator {
+private:
+    /*----1---------2---------3---------4---------5---------6---------7---*//**
+     * 構造体名 : 走査位置(Frame)
+     *            トリープ : ノードとそのノードのマッチ結果
+     *            B+木     : ページと次に処理するスロット
+    **//*-1---------2---------3---------4---------5---------6---------7------*/
+    class Frame {
+    public:
+        ::Entity::rowid_t pos;      ///< ノード・ページの要素番号
+        int32_t           slot;     ///< マッチ結果・次のスロット
+    };
+
+    const trid_t trid;                      ///< 自トランザクションID
+    const Snapshot snapshot;                ///< オープン時のスナップショット
+    const bool   flag;                      ///< 更新ロックフラグ
+    Entity&      table;                     ///< テーブルエンティティ
+    Index*       index;                     ///< インデックス(なしはnullptr)
+    const ::Entity::ImplMatcher* idx_mtcr;  ///< インデックスマッチャ
+    const ::Entity::ImplMatcher* dft_mtcr;  ///< デフォルトマッチャ
+    ::std::vector<Frame> stack;             ///< 走査位置スタック
+    ::Entity::rowid_t    scan;              ///< 全件走査位置・探索数
+    const HashMatcher*   hash_mtcr;         ///< ハッシュマッチャ
+
+public:
+    explicit IndexIterator(const trid_t, const bool, Entity&, Index*,
+            const ::Entity::rowid_t, const ::Entity::ImplMatcher* = nullptr,
+            const ::Entity::ImplMatcher* = nullptr);
+    virtual ~IndexIterator() { }
+
+    /// 次の一致タプル取得
+    ::Entity::rowid_t next();
+
+private:
+    /// トリープ左端までの下降
+    void descend_node(::Entity::rowid_t);
+    /// トリープの次の一致タプル取得
+    ::Entity::rowid_t next_node();
+    /// B+木の次の一致タプル取得
+    ::Entity::rowid_t next_page();
+    /// ハッシュの次の一致タプル取得
+    ::Entity::rowid_t next_hash();
+    /// 全件走査の次の一致タプル取得
+    ::Entity::rowid_t next_scan();
+    /// デフォルトマッチャ・更新ロック判定
+    int check_tuple(::Entity::rowid_t);
+};
+
+/*--------1---------2---------3---------4---------5---------6---------7------*/
+}  // end namespace SharedMemory
+
+#endif /* SHAREDMEMORY_INDEXITERATOR_H_ */
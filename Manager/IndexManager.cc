@@ -10,10 +10,21 @@
 *           サイズ取得                 (getSize)
 *           初期化                     (init)
 *           データ検索本体             (search_tuples)
+*           データ逐次検索開始         (open_tuples)
 *           データ挿入本体             (insert_tuple)
+*           予約要素の解除             (release_slots)
 *           データ削除本体             (delete_tuples)
+*           インデックス管理情報の検索 (find_index_root)
+*           インデックス管理情報の追加 (create_index_root)
+*           版の先頭番号の取得         (get_root_slot)
+*           版の先頭の登録             (attach_root_slot)
+*           版の先頭への連結           (link_root)
+*           版の行の回収               (unlink_root)
 *           インデックス開始位置の取得 (load_index_root)
 *           インデックス開始位置の保存 (store_index_root)
+*           インデックス開始位置の反映 (flush_index_roots)
+*           インデックス開始位置の再取得準備 (refresh_index_roots)
+*           インデックスルートのロック (lock_index_root)
 *
 *    ３  更新履歴
 *          REV001 : 新規作成
@@ -27,7 +38,9 @@
 #include <Init/Initializer.h>
 #include <Entity/IndexerCache.h>
 #include <Entity/IndexName.h>
+#include <Manager/IndexIterator.h>
 #include <Manager/IndexManager.h>
+#include <Manager/Snapshot.h>
 #include <Manager/Transaction.h>
 
 #include "inc/SHMConst.h"
@@ -42,12 +55,10 @@ using ::Entity::ImplSorter;
 using ::Entity::ImplIndexer;
 using ::Entity::AbstEntity;
 using ::Entity::IndexName;
-using ::Entity::IndexNameIndexer;
 using ::Entity::rowid_t;
 using ::Entity::INVALID_ROWID;
 using ::Entity::rowid_vec_t;
 using ::Entity::IndexerCache;
-using ::Entity::IndexNameMatcher;
 
 /**************************************************************************//**
 *
@@ -61,6 +72,7 @@ using ::Entity::IndexNameMatcher;
 *            p_rowid_vec        : 検索結果                    [出力]
 *            lock_flag          : ロックフラグ                [入力]
 *            trid               : トランザクションID          [入力]
+*            roots              : Tr内インデックスルート      [入出力]
 *            table_name         : エンティティ名              [入力]
 *            index_matcher      : インデックスマッチャ        [入力]
 *            default_matcher    : デフォルトマッチャ          [入力]
@@ -75,7 +87,7 @@ using ::Entity::IndexNameMatcher;
 * </pre>
 **//**************************************************************************/
 void IndexManager::search_tuples(rowid_vec_t& rows, const bool flag, const trid_t trid,
-        const string& tblName, AbstIndexMatcher* idxMtcr,
+        index_root_map_t& roots, const string& tblName, AbstIndexMatcher* idxMtcr,
         const ImplMatcher* dftMtcr, const ImplSorter* sorter) {
 
     if(trid == TRID_MAX) TRANSACTION_MISMATCH("トランザクションが開始されていません");
@@ -83,11 +95,14 @@ void IndexManager::search_tuples(rowid_vec_t& rows, const bool flag, const trid_
     // テーブル名よりエンティティを取得
     Entity& tbl = Entity::getAddr(tblName);
 
+    // 文のスナップショットで可視判定する
+    Snapshot::Scope snapshot(trid);
+
     // 検索
     if(idxMtcr != nullptr) {
         IndexName tpl;
         // インデックスルート取得
-        load_index_root(trid, tbl, idxMtcr->getIndexName(), tpl);
+        load_index_root(trid, roots, tbl, idxMtcr->getIndexName(), tpl);
         // インデックス名よりインデックスエンティティ取得
         Index& index = Index::getAddr(tpl.index_name);
 
@@ -101,44 +116,47 @@ void IndexManager::search_tuples(rowid_vec_t& rows, const bool flag, const trid_
         Transaction::getTrans().releaseLock();
     } else {
         // インデックスなしの全検検索
-        for(rowid_t rowid = 0; rowid < tbl.used_end; rowid++) {
-            Entry& entry = tbl.getEntry(rowid);
+        // BLOCK_SIZE件毎に共有ロックを取得し、可視ビットマスクでまとめて判定する
+        for(rowid_t base = 0; base < tbl.used_end;
+                base += static_cast<rowid_t>(Entity::BLOCK_SIZE)) {
+            const size_t num = ::std::min(Entity::BLOCK_SIZE,
+                    static_cast<size_t>(tbl.used_end - base));
             // 全体管理領域で共有ロックを取得する
             Transaction::getTrans().getLock(Header::READ_LOCK);
 
-            // エントリの可視判定
-            if(!Entity::check_tuple_readable(trid, entry)) {
-                // 不可視の場合はロック外して次ループへ
-                Transaction::getTrans().releaseLock();
-                continue;
-            }
-            const ::Entity::AbstEntity& adr = tbl.getTuple(rowid);
-            if(dftMtcr != nullptr && dftMtcr->match(adr) != 0) {
-                // マッチャがあってマッチしない場合はロック外して次ループへ
-                Transaction::getTrans().releaseLock();
-                continue;
-            }
-            // 更新ロックありの場合
-            if(flag) {
-                // 更新可否チェック
-                if(Entity::check_tuple_writable(trid, entry) == LOCKED) {
-                    // 更新不能ならばリソース開放してループを抜ける
-                    rows.clear();
-                    Transaction::getTrans().releaseLock();
-                    // 上位でタイムアウト処理してもらう
-                    TIMEOUT(tbl.getName() << " Update TimeOut");
+            // ブロックの可視判定
+            uint64_t mask = tbl.check_block_readable(trid, base, num);
+            // 可視の要素のみマッチャ・更新ロックを処理する
+            while(mask != 0) {
+                const rowid_t rowid = base + __builtin_ctzll(mask);
+                mask &= mask - 1;
+                const ::Entity::AbstEntity& adr = tbl.getTuple(rowid);
+                // マッチャがあってマッチしない場合は次の要素へ
+                if(dftMtcr != nullptr && dftMtcr->match(adr) != 0) continue;
+                // 更新ロックありの場合
+                if(flag) {
+                    Entry& entry = tbl.getEntry(rowid);
+                    // 更新可否チェック
+                    if(Entity::check_tuple_writable(trid, entry) == LOCKED) {
+                        // 更新不能ならばリソース開放してループを抜ける
+                        rows.clear();
+                        Transaction::getTrans().releaseLock();
+                        // 上位でタイムアウト処理してもらう
+                        TIMEOUT(tbl.getName() << " Update TimeOut");
+                    }
+                    // エンティティ単位で排他ロック
+                    tbl.getLock(Header::WRITE_LOCK);
+                    // 更新可能なら更新ロックを自Trに更新
+                    entry.lock = trid;
+                    tbl.mark_dirty(trid, rowid);
+                    // エンティティ単位ロック開放
+                    tbl.releaseLock();
                 }
-                // エンティティ単位で排他ロック
-                tbl.getLock(Header::WRITE_LOCK);
-                // 更新可能なら更新ロックを自Trに更新
-                entry.lock = trid;
-                // エンティティ単位ロック開放
-                tbl.releaseLock();
+                // デフォルトマッチャなしまたはマッチの場合、結果に追加
+                rows.push_back(rowid);
             }
             // 全体管理領域ロック解除
             Transaction::getTrans().releaseLock();
-            // デフォルトマッチャなしまたはマッチの場合、結果に追加
-            rows.push_back(rowid);
         }
     }
     // ソート
@@ -150,6 +168,55 @@ void IndexManager::search_tuples(rowid_vec_t& rows, const bool flag, const trid_
     return;
 }
 
+/**************************************************************************//**
+*
+*     関数名：データ逐次検索開始 (open_tuples)
+* <pre>
+*
+*    １    機能
+*            指定されたエンティティをマッチャで逐次検索するイテレータを
+*            作成する。検索結果はvectorに展開せず、フェッチ毎に取得する。
+*            インデックス順に返すためソーターは指定できない
+*
+*    ２    引数
+*            lock_flag          : ロックフラグ                [入力]
+*            trid               : トランザクションID          [入力]
+*            roots              : Tr内インデックスルート      [入出力]
+*            table_name         : エンティティ名              [入力]
+*            index_matcher      : インデックスマッチャ        [入力]
+*            default_matcher    : デフォルトマッチャ          [入力]
+*
+*    ３    戻り値
+*            イテレータ(呼出し元で破棄する)
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+IndexIterator* IndexManager::open_tuples(const bool flag, const trid_t trid,
+        index_root_map_t& roots, const string& tblName,
+        AbstIndexMatcher* idxMtcr, const ImplMatcher* dftMtcr) {
+
+    if(trid == TRID_MAX) TRANSACTION_MISMATCH("トランザクションが開始されていません");
+
+    // テーブル名よりエンティティを取得
+    Entity& tbl = Entity::getAddr(tblName);
+
+    // インデックスなしは全件走査
+    if(idxMtcr == nullptr)
+        return new IndexIterator(trid, flag, tbl, nullptr, INVALID_ROWID,
+                nullptr, dftMtcr);
+
+    IndexName tpl;
+    // インデックスルート取得
+    load_index_root(trid, roots, tbl, idxMtcr->getIndexName(), tpl);
+    // インデックス名よりインデックスエンティティ取得
+    Index& index = Index::getAddr(tpl.index_name);
+
+    return new IndexIterator(trid, flag, tbl, &index, tpl.index_root,
+            idxMtcr, dftMtcr);
+}
+
 /**************************************************************************//**
 *
 *     関数名：データ挿入本体 (insert_tuple)
@@ -160,6 +227,8 @@ void IndexManager::search_tuples(rowid_vec_t& rows, const bool flag, const trid_
 *
 *    ２    引数
 *            trid         : トランザクションID          [入力]
+*            roots        : Tr内インデックスルート      [入出力]
+*            slots        : コネクション内予約要素      [入出力]
 *            table_name   : エンティティ名              [入力]
 *            data         : 挿入対象のデータ            [入力]
 *            size         : データサイズ                [入力]
@@ -174,29 +243,53 @@ void IndexManager::search_tuples(rowid_vec_t& rows, const bool flag, const trid_
 *            REV001 : 新規作成
 * </pre>
 **//**************************************************************************/
-void IndexManager::insert_tuple(trid_t trid, const string& name,
-        const AbstEntity& table, size_t size) {
+void IndexManager::insert_tuple(trid_t trid, index_root_map_t& roots,
+        slot_reserve_map_t& slots, const string& name, const AbstEntity& table,
+        size_t size) {
 
     // 引数チェック
     if(trid == TRID_MAX) TRANSACTION_MISMATCH("トランザクションが開始されていません");
 
     Entity& tbl = Entity::getAddr(name);
 
+    // 文のスナップショットで可視判定する
+    Snapshot::Scope snapshot(trid);
+
     // サイズチェック
     if(size != tbl.tuple_size)
         LENGTH_ERROR("サイズ不一致 " << name << " (object=" << size
                 << " entity=" << tbl.tuple_size << ")");
 
-    // エンティティ単位で排他ロック
-    tbl.getLock(Header::WRITE_LOCK);
+    // 予約要素がなければまとめて予約する(ここでのみエンティティをロック)
+    rowid_vec_t& reserved = slots[name];
+    if(reserved.empty()) {
+        if(tbl.reserveTuples(reserved, SLOT_RESERVE_NUM) == 0)
+            MEMORYFULL("メモリフル:" << name);
+        // 小さい要素番号から使う
+        ::std::reverse(reserved.begin(), reserved.end());
+    }
 
     // テーブル挿入
-    rowid_t rowid = tbl.createTuple(trid);
-    tbl.releaseLock();
+    rowid_t rowid = tbl.claimTuple(trid, reserved.back());
+    reserved.pop_back();
 
     // 挿入データをコピー
     tbl.setTuple(rowid, table);
 
+    // インデックス管理情報(IndexEntryの登録)は版の先頭に連結する
+    if(Initializer::index_addr == &tbl) {
+        IndexManager& idxMgr = IndexManager::getAddr();
+        const IndexName& tpl = static_cast<const IndexName&>(table);
+        const rowid_t slot = idxMgr.attach_root_slot(tpl.entity_name.str(),
+                tpl.index_id.str());
+        Transaction& trn = Transaction::getTrans();
+        trn.getLock(Header::READ_LOCK);
+        idxMgr.getLock(Header::WRITE_LOCK);
+        idxMgr.link_root(slot, rowid, idxMgr.getRootSlot(slot).head.load());
+        idxMgr.releaseLock();
+        trn.releaseLock();
+    }
+
     // インデックス管理情報有無チェック
     if(check_index(tbl)) {
         // インデックス挿入
@@ -207,15 +300,18 @@ void IndexManager::insert_tuple(trid_t trid, const string& name,
             rowid_vec_t idxv;
             // インデックス管理情報検索
             IndexName tpl;
-            load_index_root(trid, tbl, idxid, tpl);
+            load_index_root(trid, roots, tbl, idxid, tpl);
             // インデックス管理インデックス領域取得
             Index& idx = Index::getAddr(tpl.index_name);
             // インデクサ取得
             const ImplIndexer& idxer = IndexerCache::getIndexer(tpl.indexer_name);
             // インデックス挿入
             root = idx.insertNode(trid, tpl.index_root, tbl, rowid, idxer);
+            if(root == EXECUTE_KEYERR)
+                MULTI_DEFINE("キーが重複しています " << name << ":" << idxid);
+            if(root < 0) TIMEOUT(name << ":" << idxid << " Index Insert TimeOut");
             // 挿入後のインデックスルート保管
-            store_index_root(trid, tbl, idx, idxid, tpl.indexer_name, root);
+            store_index_root(roots, tbl, idxid, root);
         }
     }   // インデックス系の処理はここまで
 
@@ -225,6 +321,32 @@ void IndexManager::insert_tuple(trid_t trid, const string& name,
     return;
 }
 
+/**************************************************************************//**
+*
+*     関数名：予約要素の解除 (release_slots)
+* <pre>
+*
+*    １    機能
+*            コネクション内の未使用の予約要素を空きに戻す
+*
+*    ２    引数
+*            slots        : コネクション内予約要素      [入出力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void IndexManager::release_slots(slot_reserve_map_t& slots) {
+    for(auto it = slots.begin(); it != slots.end(); it++) {
+        if(it->second.empty()) continue;
+        Entity::getAddr(it->first).releaseTuples(it->second);
+    }
+    slots.clear();
+}
+
 /**************************************************************************//**
 *
 *     関数名：データ削除本体 (delete_tuples)
@@ -235,6 +357,7 @@ void IndexManager::insert_tuple(trid_t trid, const string& name,
 *
 *    ２    引数
 *            trid               : トランザクションID          [入力]
+*            roots              : Tr内インデックスルート      [入出力]
 *            table_name         : エンティティ名              [入力]
 *            index_id           : インデックスID              [入力]
 *            index_matcher      : インデックスマッチャ        [入力]
@@ -248,14 +371,17 @@ void IndexManager::insert_tuple(trid_t trid, const string& name,
 *            REV001 : 新規作成
 * </pre>
 **//**************************************************************************/
-void IndexManager::delete_tuples(trid_t trid, const string& tblName,
-        AbstIndexMatcher* idxMtcr, const ImplMatcher* dftMtcr) {
+void IndexManager::delete_tuples(trid_t trid, index_root_map_t& roots,
+        const string& tblName, AbstIndexMatcher* idxMtcr, const ImplMatcher* dftMtcr) {
 
     Entity& tbl = Entity::getAddr(tblName);
 
+    // 文のスナップショットで可視判定する(検索と共用)
+    Snapshot::Scope snapshot(trid);
+
     // エンティティ本体削除対象検索(更新ロック付き)
     rowid_vec_t rows;
-    search_tuples(rows, true, trid, tblName, idxMtcr, dftMtcr);
+    search_tuples(rows, true, trid, roots, tblName, idxMtcr, dftMtcr);
 
     // インデックス管理情報有無チェック
     if(check_index(tbl)) {
@@ -266,7 +392,7 @@ void IndexManager::delete_tuples(trid_t trid, const string& tblName,
             const string& idxid = i->first;
             // インデックス管理情報検索
             IndexName tpl;
-            load_index_root(trid, tbl, idxid, tpl);
+            load_index_root(trid, roots, tbl, idxid, tpl);
             // インデックス管理インデックス領域取得
             Index& idx = Index::getAddr(tpl.index_name);
             // インデクサ取得
@@ -274,8 +400,8 @@ void IndexManager::delete_tuples(trid_t trid, const string& tblName,
             root = tpl.index_root;
             for(auto j = rows.begin(); j != rows.end(); j++)
                 root = idx.deleteNode(trid, root, tbl, *j, idxr);
-            // 全体インデックス管理情報の更新
-            store_index_root(trid, tbl, idx, idxid, tpl.indexer_name, root);
+            // Tr内インデックスルートの更新
+            store_index_root(roots, tbl, idxid, root);
         }
     }
 
@@ -293,76 +419,346 @@ void IndexManager::delete_tuples(trid_t trid, const string& tblName,
 
 /**************************************************************************//**
 *
-*     関数名：インデックス開始位置の取得 (load_index_root)
+*     関数名：インデックス管理情報の検索 (find_index_root)
 * <pre>
 *
 *    １    機能
-*            インデックス開始位置の取得
+*            エンティティ名とインデックスIDから、自Trで可視なインデックス
+*            管理情報のRowIDを取得する。
+*            キーの版の先頭(最新版)から1つ前の版へ辿り、最初に可視な行を
+*            返す。辿るのは自Trの開始後に作成された版のみのため、回収前の
+*            版の数によらない
 *
 *    ２    引数
 *           trid                : トランザクションID            [入力]
-*           entityp             : エンティティアドレス          [入力]
+*           entity_name         : エンティティ名                [入力]
 *           index_id            : インデックスID                [入力]
-*           tuple               : タプル                        [入力]
 *
 *    ３    戻り値
-*            EXECUTE_OK  : 成功
-*            EXECUTE_ERR : 失敗
-*
+*            インデックス管理情報のRowID
+*            INVALID_ROWID : 未登録
 *
 *    ４    履歴
 *            REV001 : 新規作成
 * </pre>
 **//**************************************************************************/
-void IndexManager::load_index_root(trid_t trid, Entity& ent,
-        const string& idxid, IndexName& tpl) {
+rowid_t IndexManager::find_index_root(trid_t trid, const string& entName,
+        const string& idxid) {
 
     IndexManager& idxMgr = IndexManager::getAddr();
-    if(&idxMgr == &ent) {
-        Transaction& trn = Transaction::getTrans();
-        Transaction::Recode& tr = trn.getTransaction(trid);
-        // 全体管理領域で共有ロックを取得する
-        trn.getLock(Header::READ_LOCK);
+    Transaction& trn = Transaction::getTrans();
+    const rowid_t slot = get_root_slot(entName, idxid);
+    rowid_t ret = INVALID_ROWID;
 
-        tpl.set(IndexName::ENTITY_NAME, IndexNameIndexer::INDEXER_NAME,
-                IndexNameIndexer::INDEXER_NAME, IndexNameIndexer::INDEXER_NAME,
-                tr.index_root);
+    // 全体管理領域の共有ロックを取得
+    trn.getLock(Header::READ_LOCK);
+    // 版の連結・回収と排他するため、インデックス管理情報の共有ロックを取得
+    idxMgr.getLock(Header::READ_LOCK);
+    try {
+        rowid_t rowid = idxMgr.getRootSlot(slot).head.load();
+        // 連結は行数を超えない(超えた場合は破損)
+        for(size_t n = 0; rowid != INVALID_ROWID && n < idxMgr.reserve_line; n++) {
+            if(check_tuple_readable(trid, idxMgr.getEntry(rowid))) {
+                ret = rowid;
+                break;
+            }
+            rowid = idxMgr.getRootLink(rowid).prev.load();
+        }
+    } catch(...) {
+        idxMgr.releaseLock();
+        trn.releaseLock();
+        throw;
+    }
+    idxMgr.releaseLock();
+    trn.releaseLock();
+    return ret;
+}
+
+/**************************************************************************//**
+*
+*     関数名：インデックス管理情報の追加 (create_index_root)
+* <pre>
+*
+*    １    機能
+*            エンティティ名とインデックスIDのインデックス管理情報を、
+*            インデックス開始位置なしで自Trの行として追加する。
+*            インデックス管理情報の排他ロック中に同じキーの版を確認するため、
+*            同じキーの行が複数追加されることはない。
+*            他Trが追加した版(処理中、または自Trから不可視のコミット済み)が
+*            あれば競合として追加しない。追加した行は版の先頭に連結する
+*
+*    ２    引数
+*           trid                : トランザクションID            [入力]
+*           entity_name         : エンティティ名                [入力]
+*           index_id            : インデックスID                [入力]
+*
+*    ３    戻り値
+*            追加したインデックス管理情報のRowID
+*            INVALID_ROWID : 競合
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+rowid_t IndexManager::create_index_root(trid_t trid, const string& entName,
+        const string& idxid) {
 
-        SHM_TRACE_LOG("TRN(trid:%lu) root:%ld", trid, tr.index_root);
-        SHM_DEBUG_DMP(LOAD_TRN, trn.getName().c_str(), trid, &tr, sizeof(tr));
+    auto i = Initializer::index_map.find(entName);
+    if(i == Initializer::index_map.end() || i->second.find(idxid) == i->second.end())
+        NOT_DEFINE("インデックスIDがありません");
+    auto j = i->second.find(idxid);
 
-        // 全体管理領域ロック解除
+    IndexManager& idxMgr = IndexManager::getAddr();
+    Transaction& trn = Transaction::getTrans();
+    rowid_t ret = INVALID_ROWID;
+
+    // 全体管理領域の共有ロックを取得
+    trn.getLock(Header::READ_LOCK);
+    // インデックス管理情報の排他ロックを取得
+    idxMgr.getLock(Header::WRITE_LOCK);
+    try {
+        const rowid_t slot = j->second.root_slot;
+        const rowid_t head = idxMgr.getRootSlot(slot).head.load();
+        bool conflict = false;
+        rowid_t rowid = head;
+        for(size_t n = 0; rowid != INVALID_ROWID && n < idxMgr.reserve_line
+                && !conflict; n++) {
+            // 自Trから可視の版がないので、アボート済み以外は競合
+            trid_t xmin = idxMgr.getEntry(rowid).getXmin();
+            if(Transaction::is_tr_valid_to_write(trid, xmin, Transaction::IS_XMAX)) {
+                Transaction::setBlocker(xmin);
+                conflict = true;
+            }
+            rowid = idxMgr.getRootLink(rowid).prev.load();
+        }
+        if(!conflict) {
+            IndexName tpl;
+            tpl.set(entName, idxid, j->second.index_name, j->second.indexer_name,
+                    INVALID_ROWID);
+            ret = idxMgr.createTuple(trid);
+            if(ret < 0) MEMORYFULL("メモリフル:" << idxMgr.getName());
+            idxMgr.setTuple(ret, tpl);
+            idxMgr.link_root(slot, ret, head);
+
+            SHM_DEBUG_DMP(INSERT, idxMgr.getName().c_str(), ret, &tpl, sizeof(tpl));
+        }
+    } catch(...) {
+        idxMgr.releaseLock();
         trn.releaseLock();
+        throw;
+    }
+    idxMgr.releaseLock();
+    trn.releaseLock();
+    return ret;
+}
+
+/**************************************************************************//**
+*
+*     関数名：版の先頭番号の取得 (get_root_slot)
+* <pre>
+*
+*    １    機能
+*            エンティティ名とインデックスIDから、ローカルのインデックス
+*            マップに登録時に保持した版の先頭番号を取得する
+*
+*    ２    引数
+*           entity_name         : エンティティ名                [入力]
+*           index_id            : インデックスID                [入力]
+*
+*    ３    戻り値
+*            版の先頭番号
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+rowid_t IndexManager::get_root_slot(const string& entName, const string& idxid) {
+    auto i = Initializer::index_map.find(entName);
+    if(i == Initializer::index_map.end()) NOT_DEFINE("インデックスIDがありません");
+    auto j = i->second.find(idxid);
+    if(j == i->second.end()) NOT_DEFINE("インデックスIDがありません");
+    return j->second.root_slot;
+}
+
+/**************************************************************************//**
+*
+*     関数名：版の先頭の登録 (attach_root_slot)
+* <pre>
+*
+*    １    機能
+*            エンティティ名とインデックスIDの版の先頭を検索し、なければ
+*            追加する。検索はインデックスの登録時(初期化・アタッチ)のみ
+*            行い、以降は番号で参照する
+*
+*    ２    引数
+*           entity_name         : エンティティ名                [入力]
+*           index_id            : インデックスID                [入力]
+*
+*    ３    戻り値
+*            版の先頭番号
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+rowid_t IndexManager::attach_root_slot(const string& entName, const string& idxid) {
+    rowid_t ret = INVALID_ROWID;
+    // インデックス管理情報の排他ロックを取得
+    getLock(Header::WRITE_LOCK);
+    size_t& num = getRootSlotNum();
+    for(size_t i = 0; i < num; i++) {
+        RootSlot& slot = getRootSlot(i);
+        if(slot.entity_name == entName && slot.index_id == idxid) {
+            ret = i;
+            break;
+        }
+    }
+    if(ret == INVALID_ROWID && num < reserve_line) {
+        RootSlot& slot = getRootSlot(num);
+        slot.entity_name = entName;
+        slot.index_id = idxid;
+        slot.head.store(INVALID_ROWID);
+        ret = num++;
+    }
+    releaseLock();
+    if(ret == INVALID_ROWID) MEMORYFULL("メモリフル:" << getName());
+    return ret;
+}
+
+/**************************************************************************//**
+*
+*     関数名：版の先頭への連結 (link_root)
+* <pre>
+*
+*    １    機能
+*            追加した行を版の先頭とし、1つ前の版に連結する。
+*            1つ前の版を設定してから先頭を付け替えるため、インデックス
+*            管理情報の共有ロック中に辿る側は常に連結済みの版を参照する。
+*            インデックス管理情報の排他ロック中に呼び出すこと
+*
+*    ２    引数
+*           slot                : 版の先頭番号                  [入力]
+*           rowid               : 追加した行                    [入力]
+*           prev                : 1つ前の版の行                 [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void IndexManager::link_root(rowid_t slot, rowid_t rowid, rowid_t prev) {
+    RootLink& link = getRootLink(rowid);
+    link.prev.store(prev);
+    link.slot = slot;
+    getRootSlot(slot).head.store(rowid);
+}
+
+/**************************************************************************//**
+*
+*     関数名：版の行の回収 (unlink_root)
+* <pre>
+*
+*    １    機能
+*            GCが開放する行を版の連結から外す。先頭なら1つ前の版を先頭とし、
+*            途中なら1つ後の版の連結を付け替える。連結されていない行
+*            (後の版が作成済みのアボート済みの行等)は何もしない。
+*            インデックス管理情報の排他ロック中、開放前に呼び出すこと
+*
+*    ２    引数
+*           rowid               : 開放する行                    [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void IndexManager::unlink_root(rowid_t rowid) {
+    RootLink& link = getRootLink(rowid);
+    if(link.slot == INVALID_ROWID) return;
+    RootSlot& slot = getRootSlot(link.slot);
+    const rowid_t prev = link.prev.load();
+    rowid_t next = slot.head.load();
+    if(next == rowid) {
+        slot.head.store(prev);
+    } else {
+        for(size_t n = 0; next != INVALID_ROWID && n < reserve_line; n++) {
+            RootLink& nextLink = getRootLink(next);
+            if(nextLink.prev.load() == rowid) {
+                nextLink.prev.store(prev);
+                break;
+            }
+            next = nextLink.prev.load();
+        }
+    }
+    link.slot = INVALID_ROWID;
+}
+
+/**************************************************************************//**
+*
+*     関数名：インデックス開始位置の取得 (load_index_root)
+* <pre>
+*
+*    １    機能
+*            インデックス開始位置の取得
+*            Tr内インデックスルートに保持していればそれを返し、なければ
+*            インデックス管理情報から取得してTr内インデックスルートに保持する
+*
+*    ２    引数
+*           trid                : トランザクションID            [入力]
+*           roots               : Tr内インデックスルート        [入出力]
+*           entityp             : エンティティアドレス          [入力]
+*           index_id            : インデックスID                [入力]
+*           tuple               : タプル                        [出力]
+*
+*    ３    戻り値
+*            なし
+*
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void IndexManager::load_index_root(trid_t trid, index_root_map_t& roots,
+        Entity& ent, const string& idxid, IndexName& tpl) {
+
+    IndexManager& idxMgr = IndexManager::getAddr();
+    // インデックス管理情報自身はインデックスを持たない
+    if(&idxMgr == &ent)
+        NOT_DEFINE("インデックス管理情報はインデックス検索できません");
+
+    // Tr内で取得済みならインデックス管理情報は参照しない
+    auto key = ::std::make_pair(ent.getName(), idxid);
+    auto r = roots.find(key);
+    if(r != roots.end()) {
+        tpl = r->second.tpl;
         return;
     }
 
     // TODO(指定されたIndexIDが存在するかを確認する)
     auto i = Initializer::index_map.find(ent.getName());
-    if(i != Initializer::index_map.end() &&
+    if(i == Initializer::index_map.end() ||
             i->second.find(idxid) == i->second.end())
         NOT_DEFINE("インデックスIDがありません");
     // インデックス管理領域の検索
-    IndexNameMatcher node_matcher(ent.getName(), idxid);
-    rowid_vec_t idxs;
-    search_tuples(idxs, false, trid, IndexName::ENTITY_NAME, &node_matcher);
-    // TODO(正常に検索された場合1件のみ)
-    if(idxs.size() == 1) {
-        ::memcpy(&tpl, &idxMgr.getTuple(idxs.at(0)), idxs[0]);
+    rowid_t rowid = find_index_root(trid, ent.getName(), idxid);
+    if(rowid != INVALID_ROWID) {
+        tpl = idxMgr.getIndexMapAddr(rowid);
 
         SHM_TRACE_LOG("IDX(trid:%lu rowid:%ld) root:%ld",
-                trid, idxs[0], tpl.index_root);
-        SHM_DEBUG_DMP(LOAD_IDX, idxMgr.getName().c_str(), idxs[0], &tpl,
+                trid, rowid, tpl.index_root);
+        SHM_DEBUG_DMP(LOAD_IDX, idxMgr.getName().c_str(), rowid, &tpl,
                 sizeof(tpl));
-        return;
+    } else {
+        // TODO(初期状態の場合はindex_rootにINVALID_ROWIDを返却する)
+        auto j = i->second.find(idxid);
+        tpl.set(ent.getName(), idxid, j->second.index_name,
+                j->second.indexer_name, INVALID_ROWID);
     }
-    // 複数検索された場合はNG
-    if(idxs.size() != 0) MULTI_DEFINE("複数のIndexが検索されました " << idxs.size());
-
-    // TODO(初期状態の場合はindex_rootにINVALID_ROWIDを返却する)
-    // (その他のパラメータはなくてもいい。というかわからない)
-    auto j = Initializer::index_map.find(ent.getName())->second.find(idxid);
-    tpl.set(ent.getName(), idxid, j->second.index_name,
-            j->second.indexer_name, INVALID_ROWID);
+    roots[key].tpl = tpl;
     return;
 }
 
@@ -372,73 +768,142 @@ void IndexManager::load_index_root(trid_t trid, Entity& ent,
 * <pre>
 *
 *    １    機能
-*            インデックス開始位置の取得
+*            インデックス開始位置をTr内インデックスルートに保存する。
+*            インデックス管理情報への反映はコミット時に行う
+*
+*    ２    引数
+*           roots               : Tr内インデックスルート        [入出力]
+*           entityp             : エンティティアドレス          [入力]
+*           index_id            : インデックスID                [入力]
+*           index_root          : インデックス開始位置          [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void IndexManager::store_index_root(index_root_map_t& roots, Entity& ent,
+        const string& idxid, rowid_t root) {
+
+    // load_index_rootで取得済みであること
+    auto r = roots.find(::std::make_pair(ent.getName(), idxid));
+    if(r == roots.end())
+        NOT_DEFINE("インデックスルートが取得されていません " << ent.getName()
+                << ":" << idxid);
+
+    // ルートを付け替えない場合(ハッシュ等)もコミット時に反映して
+    // インデックス管理情報の版を進め、並行する更新Trと競合させる
+    r->second.tpl.index_root = root;
+    r->second.modified = true;
+    return;
+}
+
+/**************************************************************************//**
+*
+*     関数名：インデックス開始位置の反映 (flush_index_roots)
+* <pre>
+*
+*    １    機能
+*            Tr内で更新したインデックス開始位置を、エンティティ・
+*            インデックス単位のインデックス管理情報にMVCCで保存する。
+*            コミット直前に呼び出すこと
 *
 *    ２    引数
 *           trid                : トランザクションID            [入力]
-*           entityp             : エンティティアドレス            [入力]
-*           indexp              : インデクサドレス              [入力]
-*           index_id            : インデックスID              [入力]
-*           indexer_name        : インデクサ名                [入力]
-*           index_root          : インデックス開始位置        [入力]
+*           roots               : Tr内インデックスルート        [入出力]
 *
 *    ３    戻り値
-*            インデックスルートRowID
-*            マイナス値 : 失敗
+*            なし
 *
 *
 *    ４    履歴
 *            REV001 : 新規作成
 * </pre>
 **//**************************************************************************/
-void IndexManager::store_index_root(trid_t trid, Entity& ent, Index& idx,
-        const string& idxid, const string& idxerName, rowid_t root) {
+void IndexManager::flush_index_roots(trid_t trid, index_root_map_t& roots) {
 
-    Transaction& trn = Transaction::getTrans();
-    Transaction::Recode& tr = trn.getTransaction(trid);
     IndexManager& idxMgr = IndexManager::getAddr();
 
-    // エンティティがインデックス管理情報なら
-    if(&idxMgr == &ent) {
-        // 全体管理領域で排他ロックを取得する
-        trn.getLock(Header::WRITE_LOCK);
-
-        //トランザクション情報にindex_rootを格納する。
-        SHM_TRACE_LOG("TRN(trid:%lu root:%ld -> TRNroot:%ld",
-                trid, root, tr.index_root);
-
-        tr.index_root = root;
-        // TODO(ここでindex_root_masterを上書きしてはいけない)
-        SHM_DEBUG_DMP(STORE_TRN, trn.getName().c_str(), trid, &tr, sizeof(tr));
-
-        trn.releaseLock();
+    for(auto r = roots.begin(); r != roots.end(); r++) {
+        if(!r->second.modified) continue;
+        const string& entName = r->first.first;
+        const string& idxid = r->first.second;
+        const IndexName& tpl = r->second.tpl;
+
+        rowid_t rowid = find_index_root(trid, entName, idxid);
+        // 未登録なら追加する(通常はlock_index_rootで追加済み)
+        if(rowid == INVALID_ROWID) rowid = create_index_root(trid, entName, idxid);
+        if(rowid == INVALID_ROWID)
+            LOCK_FAILED(entName << ":" << idxid << " Index Root Insert Conflict");
+        // 対象行のみを更新する(自Trの更新は上書き)
+        const rowid_t prev = rowid;
+        rowid = idxMgr.updateTuple(trid, rowid);
+        if(rowid == EXECUTE_TIMEOUT)
+            TIMEOUT(entName << ":" << idxid << " Index Root Update TimeOut");
+        if(rowid < 0) MEMORYFULL("メモリフル:" << idxMgr.getName());
+        idxMgr.setTuple(rowid, tpl);
+        // 新しい版は版の先頭に連結する
+        if(rowid != prev) {
+            Transaction& trn = Transaction::getTrans();
+            trn.getLock(Header::READ_LOCK);
+            idxMgr.getLock(Header::WRITE_LOCK);
+            idxMgr.link_root(get_root_slot(entName, idxid), rowid, prev);
+            idxMgr.releaseLock();
+            trn.releaseLock();
+        }
+        r->second.modified = false;
 
-        return;
+        SHM_TRACE_LOG("IDX(trid:%lu) root:%ld", trid, tpl.index_root);
+        SHM_DEBUG_DMP(STORE_IDX, idxMgr.getName().c_str(), tpl.index_root,
+                &tpl, sizeof(tpl));
     }
-
-    // エンティティ名-インデックスID検索用マッチャ定義
-    IndexNameMatcher node_matcher(ent.getName(), idxid);
-    // 対象のインデックス管理領域を削除
-    delete_tuples(trid, IndexName::ENTITY_NAME, &node_matcher);
-    // インデックス名称マスタの構成
-    IndexName tpl(ent.getName(), idxid, idx.getName(), idxerName, root);
-
-    // 新しいインデックス管理領域を追加
-    insert_tuple(trid, IndexName::ENTITY_NAME, tpl, sizeof(tpl));
-
-    SHM_TRACE_LOG("IDX(trid:%lu) root:%ld", trid, root);
-    SHM_DEBUG_DMP(STORE_IDX, idxMgr.getName().c_str(), root, &tpl, sizeof(tpl));
-
     return;
 }
 
+/**************************************************************************//**
+*
+*     関数名：インデックス開始位置の再取得準備 (refresh_index_roots)
+* <pre>
+*
+*    １    機能
+*            Tr内インデックスルートのうち、更新していないものを破棄して
+*            次回参照時にインデックス管理情報から取り直すようにする。
+*            READ COMMITTEDのスナップショット取り直し時に呼び出す
+*
+*    ２    引数
+*           roots               : Tr内インデックスルート        [入出力]
+*
+*    ３    戻り値
+*            なし
+*
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void IndexManager::refresh_index_roots(index_root_map_t& roots) {
+    for(auto r = roots.begin(); r != roots.end();) {
+        if(r->second.modified) {
+            r++;
+        } else {
+            r = roots.erase(r);
+        }
+    }
+}
+
 /**************************************************************************//**
 *
 *     関数名：インデックスルートをロックする (lock_index_root)
 * <pre>
 *
 *    １    機能
-*            インデックス管理インデックスのルートインデックスを更新ロックする
+*            エンティティに紐づく全インデックスのインデックス管理情報を
+*            更新ロックする。ロック対象はエンティティ単位なので、
+*            異なるエンティティへの更新は並行して行える。
+*            インデックス管理情報が未登録なら、ここで自Trの行として追加する
 *
 *    ２    引数
 *           *entity_name: ロック元のエンティティ名
@@ -452,36 +917,44 @@ void IndexManager::store_index_root(trid_t trid, Entity& ent, Index& idx,
 * </pre>
 **//**************************************************************************/
 bool IndexManager::lock_index_root(const string& entName, trid_t trid) {
-    // インデックス管理インデックスがまだ定義されていない場合は
-    // ロック取得完了とする。
-    if(Initializer::index_map.count(entName) == 0) return true;
+    // インデックスが定義されていない場合はロック取得完了とする。
+    auto it = Initializer::index_map.find(entName);
+    if(it == Initializer::index_map.end()) return true;
+    // インデックス管理情報自身はインデックスを持たない
+    if(entName == IndexName::ENTITY_NAME) return true;
 
     Transaction& trn = Transaction::getTrans();
-    Index& idx = IndexManager::getIndex();
+    IndexManager& idxMgr = IndexManager::getAddr();
 
-    bool ret = false;
-    // 全体管理領域の共有ロックを取得
-    trn.getLock(Header::READ_LOCK);
-    // TODO(root_masterの無効チェックが必要)
-    if(trn.index_root_master == INVALID_ROWID) {
-        // 無効の場合はロックを採取しないで成功を返却する
-        ret = true;
-    } else {
-        Entry& entry = idx.getEntry(trn.index_root_master);
-        // インデックス管理インデックス領域の排他ロックを取得
-        trn.getLock(Header::WRITE_LOCK);
+    for(auto i = it->second.begin(); i != it->second.end(); i++) {
+        rowid_t rowid = find_index_root(trid, entName, i->first);
+        if(rowid == INVALID_ROWID) {
+            // 未登録なら自Trで追加する。追加した行は他Trから不可視のため
+            // 更新ロックは不要。他Trが追加中なら競合とする
+            if(create_index_root(trid, entName, i->first) == INVALID_ROWID)
+                return false;
+            continue;
+        }
+
+        Entry& entry = idxMgr.getEntry(rowid);
+        bool ret = false;
+        // 全体管理領域の共有ロックを取得
+        trn.getLock(Header::READ_LOCK);
+        // インデックス管理情報の排他ロックを取得
+        idxMgr.getLock(Header::WRITE_LOCK);
         // 対象のindex_rootが読めて書き込める状態なら更新ロックを設定
         if(check_tuple_writable(trid, entry) != LOCKED) {
             entry.lock = trid;
+            idxMgr.mark_dirty(trid, rowid);
             ret = true;
         }
-        // 排他ロック開放
+        idxMgr.releaseLock();
         trn.releaseLock();
+        // 取得済みのロックは自Tr終了まで保持したままにする
+        if(!ret) return false;
     }
-    // 共有ロック開放
-    trn.releaseLock();
 
-    return ret;
+    return true;
 }
 
 /*--------1---------2---------3---------4---------5---------6---------7------*/
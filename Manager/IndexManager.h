@@ -14,6 +14,8 @@
 #include <Manager/Entity.h>
 #include <Manager/Header.h>
 #include <Manager/Index.h>
+#include <Manager/IndexRoot.h>
+#include <Manager/SlotReserve.h>
 #include <cstring>
 #include <string>
 #include <functional>
@@ -22,6 +24,8 @@
 #include "inc/SHMmacro.h"
 
 namespace SharedMemory {
+class IndexIterator;
+
 /**************************************************************************//**
 * クラス名 : インデックス管理インデックス情報クラス(CIndexManager)
 *            インデックス管理インデックス情報を管理する。
@@ -29,6 +33,27 @@ namespace SharedMemory {
 class IndexManager : public Entity {
 
 public:
+    /**********************************************************************//**
+    * 構造体名：インデックス管理情報の版の先頭(RootSlot)
+    *          エンティティ名・インデックスID毎に、最新版の行を保持する
+    **//**********************************************************************/
+    class RootSlot {
+    public:
+        ::Entity::entityname_t entity_name;     ///< エンティティ名
+        ::Entity::entityname_t index_id;        ///< インデックスID
+        ::std::atomic<::Entity::rowid_t> head;  ///< 最新版の行(なしはINVALID_ROWID)
+    };
+    /**********************************************************************//**
+    * 構造体名：インデックス管理情報の版の連結(RootLink)
+    *          行毎に、同じキーの1つ前の版の行を保持する
+    **//**********************************************************************/
+    class RootLink {
+    public:
+        ::std::atomic<::Entity::rowid_t> prev;  ///< 1つ前の版の行(なしはINVALID_ROWID)
+        ::Entity::rowid_t slot;                 ///< 連結先の版の先頭(未連結はINVALID_ROWID)
+    };
+    // 版の先頭数・版の先頭(RootSlot × MaxLine)・版の連結(RootLink × MaxLine)は
+    // 要素本体・各マップに続く。キーは行毎に異なるため、版の先頭はMaxLineで足りる
 
     /**********************************************************************//**
     *   関数名 : インデックス名称マスタ管理情報アドレス取得(getIndexMapAddr)
@@ -49,20 +74,48 @@ public:
     *   戻り値 : メモリサイズ(byte)
     **//*********************************************************************/
     static inline size_t getSize(size_t num) {
-        return Entity::getSize(num, sizeof(::Entity::IndexName));
+        return getRootOffset(num) + roundUp(sizeof(size_t), CACHE_LINE)
+                + sizeof(RootSlot) * num + sizeof(RootLink) * num;
     }
 
     /**********************************************************************//**
-    *   関数名 : 全体インデックス管理インデックス情報アドレス取得 (getIndex)
-    *            全体インデックス管理インデックス情報の先頭アドレスを取得する
+    *   関数名 : 版の管理情報オフセット取得(getRootOffset)
+    *            版の先頭数の、領域先頭からのオフセットを取得する。
+    *   引数   : num : フィールド数(LINE)                          [入力]
+    *
+    *   戻り値 : オフセット(byte)
+    **//*********************************************************************/
+    static inline size_t getRootOffset(size_t num) {
+        return roundUp(Entity::getSize(num, sizeof(::Entity::IndexName)), CACHE_LINE);
+    }
+
+    /**********************************************************************//**
+    *   関数名 : 版の先頭数取得(getRootSlotNum)
     *   引数   : なし
-    *   戻り値 : 先頭アドレスのポインタ
-    **//**********************************************************************/
-    static inline Index& getIndex() {
-        if(nullptr == Initializer::index_index_addr)
-            NULLPOINTER("インデックス管理インデックスが初期化されていません。");
+    *   戻り値 : 登録済みの版の先頭数(インデックス管理情報の排他ロック中に更新)
+    **//*********************************************************************/
+    inline size_t& getRootSlotNum() {
+        return *reinterpret_cast<size_t*>(
+                reinterpret_cast<char*>(this) + getRootOffset(reserve_line));
+    }
 
-        return *Initializer::index_index_addr;
+    /**********************************************************************//**
+    *   関数名 : 版の先頭取得(getRootSlot)
+    *   引数   : slot : 版の先頭番号                   [入力]
+    *   戻り値 : 版の先頭
+    **//*********************************************************************/
+    inline RootSlot& getRootSlot(::Entity::rowid_t slot) {
+        return reinterpret_cast<RootSlot*>(reinterpret_cast<char*>(&getRootSlotNum())
+                + roundUp(sizeof(size_t), CACHE_LINE))[slot];
+    }
+
+    /**********************************************************************//**
+    *   関数名 : 版の連結取得(getRootLink)
+    *   引数   : rowid : 行番号                        [入力]
+    *   戻り値 : 版の連結
+    **//*********************************************************************/
+    inline RootLink& getRootLink(::Entity::rowid_t rowid) {
+        return reinterpret_cast<RootLink*>(&getRootSlot(reserve_line))[rowid];
     }
 
      /**********************************************************************//**
@@ -89,57 +142,77 @@ public:
     **//***********************************************************************/
     inline void init(const ::std::string& name, const ::Entity::rowid_t num) {
         Entity::init(name, num, sizeof(::Entity::IndexName));
+        // 版の管理情報を含めた領域サイズとする
+        setMemorySize(getSize(reserve_line));
+        getRootSlotNum() = 0;
+        for(size_t i = 0; i < reserve_line; i++) {
+            getRootSlot(i).head.store(::Entity::INVALID_ROWID);
+            getRootLink(i).prev.store(::Entity::INVALID_ROWID);
+            getRootLink(i).slot = ::Entity::INVALID_ROWID;
+        }
     }
 
+    /// 版の先頭の登録
+    ::Entity::rowid_t attach_root_slot(const ::std::string&, const ::std::string&);
+    /// 版の行の回収
+    void unlink_root(::Entity::rowid_t);
+
     /// 検索
     static void search_tuples(::Entity::rowid_vec_t&, const bool,
-            const trid_t, const ::std::string&,
+            const trid_t, index_root_map_t&, const ::std::string&,
             ::Entity::AbstIndexMatcher* = nullptr,
             const ::Entity::ImplMatcher* = nullptr,
             const ::Entity::ImplSorter* = nullptr);
+    /// 逐次検索開始
+    static IndexIterator* open_tuples(const bool, const trid_t,
+            index_root_map_t&, const ::std::string&,
+            ::Entity::AbstIndexMatcher* = nullptr,
+            const ::Entity::ImplMatcher* = nullptr);
     /// 登録
-    static void insert_tuple(trid_t, const ::std::string&,
-            const ::Entity::AbstEntity&, size_t size);
+    static void insert_tuple(trid_t, index_root_map_t&, slot_reserve_map_t&,
+            const ::std::string&, const ::Entity::AbstEntity&, size_t size);
+    /// 予約要素の解除
+    static void release_slots(slot_reserve_map_t&);
     /// 削除
-    static void delete_tuples(trid_t, const ::std::string&,
+    static void delete_tuples(trid_t, index_root_map_t&, const ::std::string&,
             ::Entity::AbstIndexMatcher* = nullptr,
             const ::Entity::ImplMatcher* = nullptr);
 public:
     /// インデックスルート更新ロック
     static bool lock_index_root(const ::std::string&, trid_t);
-
-    /**********************************************************************//**
-    *   関数名 : インデックスルート参照確認(is_index_root_valid)
-    *            指定したTrIDとRowIDのインデックス管理インデックスが
-    *            参照可能かを確認する。
-    *   引数   : trid    : トランザクションID(TrID)
-    *            root    : インデックスルート(RowID)
-    *   戻り値 : true    : 参照可能
-    *            false   : 参照不可能
-    **//**********************************************************************/
-    static inline bool is_index_root_valid(trid_t trid, ::Entity::rowid_t root) {
-        if(nullptr == Initializer::index_index_addr) return false;
-        if(::Entity::INVALID_ROWID == root) return false;
-        if(Entity::check_tuple_readable(trid, getIndex().getEntry(root))) return true;
-        return false;
-    }
+    /// Tr内インデックスルート反映
+    static void flush_index_roots(trid_t, index_root_map_t&);
+    /// Tr内インデックスルート再取得準備
+    static void refresh_index_roots(index_root_map_t&);
 
 private:
+    /// インデックス管理情報検索
+    static ::Entity::rowid_t find_index_root(trid_t, const ::std::string&,
+            const ::std::string&);
+    /// インデックス管理情報追加
+    static ::Entity::rowid_t create_index_root(trid_t, const ::std::string&,
+            const ::std::string&);
+    /// 版の先頭番号取得
+    static ::Entity::rowid_t get_root_slot(const ::std::string&, const ::std::string&);
+    /// 版の先頭への連結
+    void link_root(::Entity::rowid_t, ::Entity::rowid_t, ::Entity::rowid_t);
     /// インデックスルート取得
-    static void load_index_root(trid_t, Entity&,
+    static void load_index_root(trid_t, index_root_map_t&, Entity&,
             const ::std::string&, ::Entity::IndexName&);
     /// インデックスルート保管
-    static void store_index_root(trid_t, Entity&,
-            Index&, const ::std::string&, const ::std::string&, ::Entity::rowid_t);
+    static void store_index_root(index_root_map_t&, Entity&,
+            const ::std::string&, ::Entity::rowid_t);
 private:
     /**********************************************************************//**
     *    関数名 : エンティティにインデックスが紐づいているか確認(check_index)
     *             エンティティにインデックスが紐づいているか確認する。
+    *             インデックス管理情報自身は版の先頭から辿るためインデックスなし
     *    引数   : ent     : エンティティのポインタ
     *    戻り値 : true    : あり
     *             false   : なし
     **//**********************************************************************/
     static inline bool check_index(Entity& ent) {
+        if(ent.getName() == ::Entity::IndexName::ENTITY_NAME) return false;
         if(Initializer::index_map.find(ent.getName()) !=
                 Initializer::index_map.end()) return true;
         return false;
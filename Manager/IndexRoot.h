@@ -0,0 +1,47 @@
+/**************************************************************************//**
+* @file
+*     モジュール名：共通メモリ管理機能 トランザクション内インデックスルート
+* <pre>
+*
+*    １  機能
+*          トランザクション中に参照・更新したインデックスルートを、
+*          コネクション内に保持するための型を定義する
+*
+*    ２  更新履歴
+*          REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+#ifndef SHAREDMEMORY_INDEXROOT_H_
+#define SHAREDMEMORY_INDEXROOT_H_
+
+#include <Entity/IndexName.h>
+#include <map>
+#include <string>
+#include <utility>
+
+namespace SharedMemory
+{
+/**************************************************************************//**
+* クラス名 : トランザクション内インデックスルート(IndexRoot)
+* <pre>
+*          インデックス管理情報から取得したインデックスルートを保持する。
+*          更新はここにのみ行い、コミット時にまとめてインデックス管理情報
+*          へ反映する
+* </pre>
+**//**************************************************************************/
+class IndexRoot {
+public:
+    ::Entity::IndexName tpl;    ///< インデックス管理情報
+    bool modified;              ///< 更新有無(コミット時に反映する)
+
+    IndexRoot() : tpl(), modified(false) { }
+};
+
+/// トランザクション内インデックスルート(キー：エンティティ名,インデックスID)
+typedef ::std::map<::std::pair<::std::string, ::std::string>, IndexRoot>
+        index_root_map_t;
+
+/*--------1---------2---------3---------4---------5---------6---------7------*/
+}  // end namespace SharedMemory
+
+#endif /* SHAREDMEMORY_INDEXROOT_H_ */
@@ -0,0 +1,327 @@
+/**************************************************************************//**
+* @file
+*     モジュール名：共通メモリ管理機能 共有メモリ内リードライトロック
+* <pre>
+*
+*    １  機能
+*          基盤共有メモリ内に配置するプロセス間リードライトロックを実装する
+*
+*    ２  関数名一覧
+*           初期化             (init)
+*           共有ロック取得     (lockShared)
+*           共有ロック開放     (unlockShared)
+*           排他ロック取得     (lock)
+*           共有ロック開放待ち合わせ (waitShared)
+*           排他ロック開放     (unlock)
+*           終了したセッションの共有ロック回収 (releaseSession)
+*           共有ロック保持の記録を落とす (clearShared)
+*           共有ロック保持の有無 (hasShared)
+*
+*    ３  更新履歴
+*          REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+#include <Manager/Futex.h>
+#include <Manager/SharedLock.h>
+#include <cerrno>
+
+#include "inc/SHMmacro.h"
+
+namespace SharedMemory
+{
+
+/**************************************************************************//**
+*
+*     関数名：初期化 (init)
+* <pre>
+*
+*    １    機能
+*            プロセス間共有・ロバスト属性でミューテックスを初期化し、
+*            共有ロックの保持記録と排他フラグをクリアする
+*
+*    ２    引数
+*            なし
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void SharedLock::init() {
+    pthread_mutexattr_t attr;
+
+    if(::pthread_mutexattr_init(&attr) != 0)
+        LOCK_FAILED("ミューテックス属性の初期化に失敗しました");
+    ::pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    ::pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    int ret = ::pthread_mutex_init(&mutex, &attr);
+    ::pthread_mutexattr_destroy(&attr);
+    if(ret != 0) LOCK_FAILED("ミューテックスの初期化に失敗しました:" << ret);
+
+    writer.store(0);
+    release_seq.store(0);
+    anonymous.store(0);
+    for(size_t i = 0; i < MAX_SESSION / 64; i++) holders[i].store(0);
+}
+
+/**************************************************************************//**
+*
+*     関数名：排他ミューテックス取得 (lockMutex)
+* <pre>
+*
+*    １    機能
+*            排他ミューテックスを取得する。
+*            保持プロセスが異常終了していた場合(EOWNERDEAD)は、排他フラグを
+*            クリアしてミューテックスを整合状態に戻す
+*
+*    ２    引数
+*            なし
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void SharedLock::lockMutex() {
+    int ret = ::pthread_mutex_lock(&mutex);
+    if(ret == EOWNERDEAD) {
+        // 排他ロック保持中に終了したプロセスの状態を回収する
+        SHM_WARN_LOG("排他ロック保持プロセスの異常終了を検出しました");
+        writer.store(0);
+        ret = ::pthread_mutex_consistent(&mutex);
+    }
+    if(ret != 0) LOCK_FAILED("ミューテックスの取得に失敗しました:" << ret);
+}
+
+/**************************************************************************//**
+*
+*     関数名：共有ロック取得 (lockShared)
+* <pre>
+*
+*    １    機能
+*            保持セッションのビットを立てて共有ロックを取得する。
+*            セッション未登録の場合は未登録の保持数を加算する。
+*            排他ロックの保持・待ち合わせがあれば取り消し、
+*            排他ミューテックスの開放を待ってから再試行する
+*
+*    ２    引数
+*            session  : セッション番号(NO_SESSIONは未登録)   [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void SharedLock::lockShared(uint32_t session) {
+    for(;;) {
+        if(session < MAX_SESSION) {
+            holders[session / 64].fetch_or(1uL << (session % 64));
+        } else {
+            anonymous.fetch_add(1);
+        }
+        if(writer.load() == 0) return;
+
+        // 排他ロック側を優先するため取り消して待ち合わせる
+        unlockShared(session);
+        lockMutex();
+        ::pthread_mutex_unlock(&mutex);
+    }
+}
+
+/**************************************************************************//**
+*
+*     関数名：共有ロック開放 (unlockShared)
+* <pre>
+*
+*    １    機能
+*            共有ロックの保持記録を落とし、排他ロック待ちがあれば起床する
+*
+*    ２    引数
+*            session  : セッション番号(NO_SESSIONは未登録)   [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void SharedLock::unlockShared(uint32_t session) {
+    if(clearShared(session) && writer.load() != 0) {
+        release_seq.fetch_add(1);
+        Futex::wake(release_seq);
+    }
+}
+
+/**************************************************************************//**
+*
+*     関数名：排他ロック取得 (lock)
+* <pre>
+*
+*    １    機能
+*            排他ミューテックスを取得し、排他フラグを立てる。
+*            共有ロックの開放はwaitSharedで待ち合わせる
+*
+*    ２    引数
+*            なし
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void SharedLock::lock() {
+    lockMutex();
+    writer.store(1);
+}
+
+/**************************************************************************//**
+*
+*     関数名：共有ロック開放待ち合わせ (waitShared)
+* <pre>
+*
+*    １    機能
+*            排他フラグを立てた後、全ての共有ロックが開放されるまで
+*            待ち合わせる。指定時間内に開放されなければ戻り、呼出し元で
+*            終了したプロセスの共有ロックを回収(releaseSession)してから
+*            再度呼び出す
+*
+*    ２    引数
+*            msec     : 最大待ち時間(ms)                      [入力]
+*
+*    ３    戻り値
+*            true  : 全ての共有ロックが開放された
+*            false : タイムアウト
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+bool SharedLock::waitShared(uint64_t msec) {
+    for(;;) {
+        // 開放通番を先に読み、確認後の開放を取りこぼさない
+        const uint32_t seq = release_seq.load();
+        if(!hasShared()) return true;
+        if(Futex::wait(release_seq, seq, msec) != 0 && errno == ETIMEDOUT)
+            return false;
+    }
+}
+
+/**************************************************************************//**
+*
+*     関数名：排他ロック開放 (unlock)
+* <pre>
+*
+*    １    機能
+*            排他フラグを落として排他ミューテックスを開放する
+*
+*    ２    引数
+*            なし
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void SharedLock::unlock() {
+    writer.store(0);
+    int ret = ::pthread_mutex_unlock(&mutex);
+    if(ret != 0) LOCK_FAILED("ミューテックスの開放に失敗しました:" << ret);
+}
+
+/**************************************************************************//**
+*
+*     関数名：終了したセッションの共有ロック回収 (releaseSession)
+* <pre>
+*
+*    １    機能
+*            終了したプロセスのセッションが保持していた共有ロックを開放し、
+*            排他ロック待ちを起床する。セッションを回収する処理から、
+*            同じセッションに再登録される前に呼び出すこと
+*
+*    ２    引数
+*            session  : セッション番号                       [入力]
+*
+*    ３    戻り値
+*            true  : 共有ロックを保持していた
+*            false : 保持していない
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+bool SharedLock::releaseSession(uint32_t session) {
+    if(session >= MAX_SESSION || !clearShared(session)) return false;
+    release_seq.fetch_add(1);
+    Futex::wake(release_seq);
+    return true;
+}
+
+/**************************************************************************//**
+*
+*     関数名：共有ロック保持の記録を落とす (clearShared)
+* <pre>
+*
+*    １    機能
+*            セッションのビットを落とす。未登録の場合は保持数を減算する
+*
+*    ２    引数
+*            session  : セッション番号(NO_SESSIONは未登録)   [入力]
+*
+*    ３    戻り値
+*            true  : 保持の記録を落とした
+*            false : 保持の記録がない
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+bool SharedLock::clearShared(uint32_t session) {
+    if(session >= MAX_SESSION) {
+        anonymous.fetch_sub(1);
+        return true;
+    }
+    const uint64_t bit = 1uL << (session % 64);
+    return (holders[session / 64].fetch_and(~bit) & bit) != 0;
+}
+
+/**************************************************************************//**
+*
+*     関数名：共有ロック保持の有無 (hasShared)
+* <pre>
+*
+*    １    機能
+*            共有ロックを保持しているセッション・未登録プロセスの有無を
+*            確認する
+*
+*    ２    引数
+*            なし
+*
+*    ３    戻り値
+*            true  : 保持あり
+*            false : 保持なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+bool SharedLock::hasShared() const {
+    if(anonymous.load() != 0) return true;
+    for(size_t i = 0; i < MAX_SESSION / 64; i++) {
+        if(holders[i].load() != 0) return true;
+    }
+    return false;
+}
+
+/*--------1---------2---------3---------4---------5---------6---------7------*/
+}  // end namespace SharedMemory
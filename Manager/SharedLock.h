@@ -0,0 +1,84 @@
+/**************************************************************************//**
+* @file
+*     モジュール名：共通メモリ管理機能 共有メモリ内リードライトロック
+* <pre>
+*
+*    １  機能
+*          基盤共有メモリ内に配置するプロセス間リードライトロックを定義する
+*
+*    ２  更新履歴
+*          REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+#ifndef SHAREDMEMORY_SHAREDLOCK_H_
+#define SHAREDMEMORY_SHAREDLOCK_H_
+
+#include <pthread.h>
+
+#include <atomic>
+#include <cstdint>
+
+namespace SharedMemory
+{
+/**************************************************************************//**
+* クラス名 : 共有メモリ内リードライトロック(SharedLock)
+* <pre>
+*          共有ロックは保持セッションのビットを立てるアトミック演算のみで
+*          取得するため、競合がなければシステムコールを発行しない。
+*          共有ロックはプロセス単位で1つだけ保持する(Header::lockProcess)
+*          ため、セッション毎に1ビットで保持を表せる。
+*          排他ロックはPTHREAD_MUTEX_ROBUST属性のミューテックスで取得し、
+*          保持プロセスが異常終了した場合はEOWNERDEADで回収する。
+*          共有ロックを保持したまま終了したプロセスは、セッションの回収時に
+*          releaseSessionでビットを落として回収する。
+*          排他ロック保持中・待ち合わせ中の共有ロックはミューテックスで
+*          待ち合わせ、排他ロックは開放通番ワードをfutexで待ち合わせる。
+* </pre>
+**//**************************************************************************/
+class SharedLock {
+public:
+    /// 共有ロックの保持を記録するセッション数
+    static const uint32_t MAX_SESSION = 1024;
+    /// セッション未登録(保持を記録しない)
+    static const uint32_t NO_SESSION = ~0u;
+    /// 共有ロックの開放待ちで、保持プロセスの終了を確認する間隔(ms)
+    static const uint64_t RECOVER_MSEC = 1000;
+
+private:
+    pthread_mutex_t        mutex;       ///< 排他ロック(ロバストミューテックス)
+    ::std::atomic<uint32_t> writer;     ///< 排他ロック保持・待ち合わせフラグ
+    ::std::atomic<uint32_t> release_seq;///< 共有ロック開放通番(futexワード)
+    ::std::atomic<uint32_t> anonymous;  ///< セッション未登録の共有ロック保持数
+    ::std::atomic<uint64_t> holders[MAX_SESSION / 64];  ///< 共有ロック保持セッション
+
+    /// コンストラクタ(無効)
+    SharedLock();
+
+    /// 排他ミューテックス取得(異常終了プロセスの回収含む)
+    void lockMutex();
+    /// 共有ロック保持の記録を落とす
+    bool clearShared(uint32_t);
+    /// 共有ロック保持の有無
+    bool hasShared() const;
+
+public:
+    /// 初期化
+    void init();
+    /// 共有ロック取得
+    void lockShared(uint32_t);
+    /// 共有ロック開放
+    void unlockShared(uint32_t);
+    /// 排他ロック取得
+    void lock();
+    /// 共有ロック開放待ち合わせ
+    bool waitShared(uint64_t);
+    /// 排他ロック開放
+    void unlock();
+    /// 終了したセッションの共有ロック回収
+    bool releaseSession(uint32_t);
+};
+
+/*--------1---------2---------3---------4---------5---------6---------7------*/
+}  // end namespace SharedMemory
+
+#endif /* SHAREDMEMORY_SHAREDLOCK_H_ */
@@ -0,0 +1,33 @@
+/**************************************************************************//**
+* @file
+*     モジュール名：共通メモリ管理機能 コネクション内予約要素
+* <pre>
+*
+*    １  機能
+*          挿入用にまとめて予約した要素番号を、コネクション内に保持する
+*          ための型を定義する
+*
+*    ２  更新履歴
+*          REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+#ifndef SHAREDMEMORY_SLOTRESERVE_H_
+#define SHAREDMEMORY_SLOTRESERVE_H_
+
+#include <Entity/AppTable.h>
+#include <map>
+#include <string>
+
+namespace SharedMemory
+{
+/// 一度に予約する要素数
+static const size_t SLOT_RESERVE_NUM = 64;
+
+/// コネクション内予約要素(キー：エンティティ名、値：未使用の予約要素番号)
+/// 要素番号は末尾から使う。未使用の要素はトランザクション終了時に空きに戻す
+typedef ::std::map<::std::string, ::Entity::rowid_vec_t> slot_reserve_map_t;
+
+/*--------1---------2---------3---------4---------5---------6---------7------*/
+}  // end namespace SharedMemory
+
+#endif /* SHAREDMEMORY_SLOTRESERVE_H_ */
@@ -0,0 +1,277 @@
+/**************************************************************************//**
+* @file
+*     モジュール名：共通メモリ管理機能 スナップショットクラス
+* <pre>
+*
+*    １  機能
+*          文単位のスナップショットクラス
+*
+*    ２  関数名一覧
+*           コンストラクタ                     (Snapshot)
+*           コミットTRCC取得                   (getTrccEnd)
+*           トランザクション可視判定           (is_tr_valid_to_read)
+*           コミット済みトランザクション可視判定 (is_trcc_visible)
+*           有効なスナップショット取得         (getCurrent)
+*           有効範囲開始・終了                 (Scope)
+*
+*    ３  更新履歴
+*          REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+#include <Manager/Snapshot.h>
+
+#include "inc/SHMConst.h"
+#include "inc/SHMmacro.h"
+
+namespace SharedMemory
+{
+/// スレッドで有効なスナップショット
+thread_local const Snapshot* current_snapshot = nullptr;
+
+/**************************************************************************//**
+*
+*     関数名：コンストラクタ (Snapshot)
+* <pre>
+*
+*    １    機能
+*            トランザクション管理情報から、自Trのtrcc_beginと未回収TRIDの
+*            範囲を写し取る。TRID毎の状態は参照時に写し取るため、作成の
+*            処理量は未回収TRIDの数によらない
+*
+*    ２    引数
+*            trid     : 自トランザクションID          [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+Snapshot::Snapshot(trid_t trid) : trid(trid), trcc_begin(TRCC_MAX) {
+    Transaction& trn = Transaction::getTrans();
+    collecting = trn.trid_collecting.load(::std::memory_order_acquire);
+    next = trn.trid_next.load(::std::memory_order_acquire);
+
+    // 自TrIDが有効ならtrcc_beginを保存
+    if(collecting <= trid && trid < next)
+        trcc_begin = trn.tag_transaction[trid % trn.getMaxLine()].trcc_begin;
+}
+
+/**************************************************************************//**
+*
+*     関数名：コミットTRCC取得 (getTrccEnd)
+* <pre>
+*
+*    １    機能
+*            [collecting,next)のTRIDのコミットTRCC(処理中・アボート・回収済み
+*            は印)を返す。初回はトランザクション管理情報から写し取って保持
+*            し、以降は保持した値を返す。
+*            作成後に回収されたTRIDも管理配列は直接参照するため範囲外には
+*            ならない
+*
+*    ２    引数
+*            target_trid  : 対象のトランザクションID   [入力]
+*
+*    ３    戻り値
+*            コミットTRCC、またはCC_COLLECTED/CC_IN_PROGRESS/CC_ABORTED
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+trcc_t Snapshot::getTrccEnd(trid_t tgtTrid) const {
+    auto it = trcc_ends.find(tgtTrid);
+    if(it != trcc_ends.end()) return it->second;
+
+    Transaction& trn = Transaction::getTrans();
+    Transaction::Recode& tr = trn.tag_transaction[tgtTrid % trn.getMaxLine()];
+    trcc_t cc;
+    if(tr.trid.load(::std::memory_order_acquire) != tgtTrid) {
+        // 公開前は処理中、前周に戻っていれば回収済み
+        cc = tgtTrid < trn.trid_collecting.load() ? CC_COLLECTED : CC_IN_PROGRESS;
+    } else {
+        switch(tr.status.load(::std::memory_order_acquire)) {
+        case Transaction::COMMITTED:
+            cc = tr.trcc_end;
+            break;
+        case Transaction::ABORTED:
+            cc = CC_ABORTED;
+            break;
+        default:
+            cc = CC_IN_PROGRESS;
+            break;
+        }
+    }
+    trcc_ends.emplace(tgtTrid, cc);
+    return cc;
+}
+
+/**************************************************************************//**
+*
+*     関数名：トランザクション可視判定 (is_tr_valid_to_read)
+* <pre>
+*
+*    １    機能
+*            Transaction::is_tr_valid_to_readと同じ判定を、スナップショット
+*            の内容のみで行う
+*
+*    ２    引数
+*            target_trid  : 対象のトランザクションID
+*            status       : 確定した対象Trの状態(未確定はIN_PROGRESS) [出力]
+*            trcc_end     : 対象TrのコミットTRCC(COMMITTEDのみ)       [出力]
+*
+*    ３    戻り値
+*            true  : 取得可能
+*            false : 取得不能
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+bool Snapshot::is_tr_valid_to_read(trid_t tgtTrid, Transaction::Status* status,
+        trcc_t* trccEnd) const {
+    if(status != nullptr) *status = Transaction::IN_PROGRESS;
+    // 自身のTRIDが対象ならば取得可能
+    if(tgtTrid == trid) return true;
+    // 回収済みのTRIDは全てコミット扱いなので取得可能
+    if(tgtTrid < collecting) return true;
+    // 作成後のTRID(TRID_MAXを含む)は自trcc_begin以降にコミットするので取得不能
+    if(next <= tgtTrid) return false;
+
+    trcc_t cc = getTrccEnd(tgtTrid);
+    if(cc == CC_COLLECTED) return true;
+    if(cc == CC_IN_PROGRESS) return false;
+    if(cc == CC_ABORTED) {
+        if(status != nullptr) *status = Transaction::ABORTED;
+        return false;
+    }
+    if(status != nullptr) *status = Transaction::COMMITTED;
+    if(trccEnd != nullptr) *trccEnd = cc;
+    // 対象Trのtrcc_endよりも自trcc_beginの方が後なら可視
+    return cc < trcc_begin;
+}
+
+/**************************************************************************//**
+*
+*     関数名：コミット済みトランザクション可視判定 (is_trcc_visible)
+* <pre>
+*
+*    １    機能
+*            Transaction::is_trcc_visibleと同じ判定を、スナップショット
+*            の内容のみで行う
+*
+*    ２    引数
+*            target_trid  : 対象のトランザクションID
+*            trcc_end     : 対象TrのコミットTRCC(下位32ビット)
+*
+*    ３    戻り値
+*            true  : 取得可能
+*            false : 取得不能
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+bool Snapshot::is_trcc_visible(trid_t tgtTrid, uint32_t trccEnd) const {
+    // 回収済みのTRIDは全てコミット扱いなので取得可能
+    if(tgtTrid < collecting) return true;
+    // 自TrIDが無効なら全てのコミットが可視
+    if(trcc_begin == TRCC_MAX) return true;
+    return static_cast<int32_t>(trccEnd - static_cast<uint32_t>(trcc_begin)) < 0;
+}
+
+/**************************************************************************//**
+*
+*     関数名：有効なスナップショット取得 (getCurrent)
+* <pre>
+*
+*    １    機能
+*            スレッドで有効なスナップショットが指定TrIDのものなら返す
+*
+*    ２    引数
+*            trid     : 自トランザクションID          [入力]
+*
+*    ３    戻り値
+*            スナップショット(なければnullptr)
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+const Snapshot* Snapshot::getCurrent(trid_t trid) {
+    if(current_snapshot == nullptr || current_snapshot->trid != trid)
+        return nullptr;
+    return current_snapshot;
+}
+
+/**************************************************************************//**
+*
+*     関数名：有効範囲開始 (Scope)
+* <pre>
+*
+*    １    機能
+*            指定TrIDのスナップショットが有効でなければ作成して有効にする
+*
+*    ２    引数
+*            trid     : 自トランザクションID          [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+Snapshot::Scope::Scope(trid_t trid) : prev(current_snapshot) {
+    if(trid == TRID_MAX || getCurrent(trid) != nullptr) return;
+    own.reset(new Snapshot(trid));
+    current_snapshot = own.get();
+}
+
+/**************************************************************************//**
+*
+*     関数名：有効範囲開始 (Scope)
+* <pre>
+*
+*    １    機能
+*            作成済みのスナップショットを有効にする
+*
+*    ２    引数
+*            snapshot : スナップショット              [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+Snapshot::Scope::Scope(const Snapshot& snapshot) : prev(current_snapshot) {
+    current_snapshot = &snapshot;
+}
+
+/**************************************************************************//**
+*
+*     関数名：有効範囲終了 (~Scope)
+* <pre>
+*
+*    １    機能
+*            外側のスナップショットに戻す
+*
+*    ２    引数
+*            なし
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+Snapshot::Scope::~Scope() {
+    current_snapshot = prev;
+}
+
+/*--------1---------2---------3---------4---------5---------6---------7------*/
+}  // end namespace SharedMemory
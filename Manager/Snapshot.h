@@ -0,0 +1,100 @@
+/**************************************************************************//**
+* @file
+*     モジュール名：共通メモリ管理機能 スナップショットクラスヘッダ
+* <pre>
+*
+*    １  機能
+*          文(検索・更新)単位で、可視判定に必要なトランザクション管理情報を
+*          プロセス内に写し取るスナップショットクラスを定義する
+*
+*    ２  更新履歴
+*          REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+#ifndef SHAREDMEMORY_SNAPSHOT_H_
+#define SHAREDMEMORY_SNAPSHOT_H_
+
+#include <Manager/Transaction.h>
+
+#include <memory>
+#include <unordered_map>
+
+namespace SharedMemory
+{
+/**************************************************************************//**
+* クラス名 : スナップショットクラス(Snapshot)
+* <pre>
+*          作成時点の自Trのtrcc_begin、trid_collecting、trid_nextを保持し、
+*          未回収TRID毎のコミットTRCC(処理中・アボートは印)は参照された
+*          TRIDのみ初回にトランザクション管理情報から写し取る。
+*          2回目以降の可視判定は共有メモリを参照せずに行う。
+*          作成後にコミットしたTrは自trcc_begin以降のTRCCとなり不可視の
+*          ため、写し取る時点が作成後でも判定結果は変わらない。
+*          スナップショットは作成したスレッドのみで使用すること。
+*          Scopeで有効にしている間、同じスレッドの同じTrIDの可視判定
+*          (Entity::check_tuple_readable)はこのスナップショットを使う
+* </pre>
+**//**************************************************************************/
+class Snapshot {
+private:
+    static const trcc_t CC_COLLECTED   = TRCC_MAX - 2;  ///< 作成中に回収済み
+    static const trcc_t CC_IN_PROGRESS = TRCC_MAX - 1;  ///< 処理中(公開前を含む)
+    static const trcc_t CC_ABORTED     = TRCC_MAX;      ///< アボート済み
+
+    trid_t trid;                        ///< 自トランザクションID
+    trcc_t trcc_begin;                  ///< 自Trの処理開始時TRCC
+    trid_t collecting;                  ///< 作成時の最古の未回収TRID
+    trid_t next;                        ///< 作成時の次のTRID
+    /// 参照済みTRIDのコミットTRCC([collecting,next)の範囲のみ)
+    mutable ::std::unordered_map<trid_t, trcc_t> trcc_ends;
+
+    /// コミットTRCC取得
+    trcc_t getTrccEnd(trid_t) const;
+
+public:
+    explicit Snapshot(trid_t);
+    virtual ~Snapshot() { }
+
+    /**********************************************************************//**
+    *   関数名 : トランザクションID取得(getTrID)
+    *   引数   : なし
+    *   戻り値 : スナップショットを作成したTrID
+    **//*********************************************************************/
+    inline trid_t getTrID() const { return trid; }
+
+    /**********************************************************************//**
+    *   関数名 : 最古の未回収TRID取得(getCollecting)
+    *   引数   : なし
+    *   戻り値 : 作成時のtrid_collecting(これ未満のTrは全てコミット扱い)
+    **//*********************************************************************/
+    inline trid_t getCollecting() const { return collecting; }
+
+    /// トランザクション可視判定
+    bool is_tr_valid_to_read(trid_t, Transaction::Status* = nullptr,
+            trcc_t* = nullptr) const;
+    /// コミット済みトランザクション可視判定(ヒントビット用)
+    bool is_trcc_visible(trid_t, uint32_t) const;
+    /// 有効なスナップショット取得
+    static const Snapshot* getCurrent(trid_t);
+
+    /**********************************************************************//**
+    * クラス名 : スナップショット有効範囲(Scope)
+    *            生存期間中、スレッドのスナップショットを有効にする。
+    *            TrIDを指定した場合は、同じTrIDのスナップショットが有効で
+    *            なければ作成する(入れ子の文では外側を使う)
+    **//*********************************************************************/
+    class Scope {
+    private:
+        const Snapshot* prev;               ///< 外側のスナップショット
+        ::std::unique_ptr<Snapshot> own;    ///< 作成したスナップショット
+    public:
+        explicit Scope(trid_t);
+        explicit Scope(const Snapshot&);
+        virtual ~Scope();
+    };
+};
+
+/*--------1---------2---------3---------4---------5---------6---------7------*/
+}  // end namespace SharedMemory
+
+#endif /* SHAREDMEMORY_SNAPSHOT_H_ */
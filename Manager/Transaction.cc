@@ -12,9 +12,13 @@
 * </pre>
 **//**************************************************************************/
 #include <Init/Initializer.h>
-#include <Manager/Index.h>
-#include <Manager/IndexManager.h>
+#include <Manager/Entity.h>
+#include <Manager/Futex.h>
 #include <Manager/Transaction.h>
+#include <errno.h>
+#include <sched.h>
+#include <time.h>
+#include <mutex>
 #include "inc/SHMmacro.h"
 
 namespace SharedMemory
@@ -23,6 +27,24 @@ using ::std::string;
 
 const string Transaction::TRANSACTION_NAME  = "$";
 
+namespace {
+/// 書込み不可の原因となったトランザクション(スレッド単位)
+thread_local trid_t blocker_trid = TRID_MAX;
+/// 自プロセスのセッション(プロセス単位)
+::std::atomic<session_t> self_session(SESSION_NONE);
+/// セッション登録・解除の排他(プロセス単位)
+::std::mutex session_mutex;
+/// fork後の子プロセスは親のセッションを引き継がない
+void reset_session() { self_session.store(SESSION_NONE); }
+/// 現在時刻取得(ms、単調増加)
+uint64_t msecNow() {
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000uL
+            + static_cast<uint64_t>(ts.tv_nsec) / 1000000uL;
+}
+}
+
 /**********************************************************************//**
 *
 *     関数名：全体トランザクション管理情報サイズ取得 (getSize)
@@ -34,6 +56,7 @@ const string Transaction::TRANSACTION_NAME  = "$";
 *
 *    ２    引数
 *            num       :    管理情報数     [入力]
+*            sessions  :    セッション数   [入力]
 *
 *    ３    戻り値
 *            メモリサイズ(byte)
@@ -42,8 +65,8 @@ const string Transaction::TRANSACTION_NAME  = "$";
 *            REV001 : 新規作成
 * </pre>
 **//**********************************************************************/
-size_t Transaction::getSize(size_t num) {
-    return sizeof(Transaction) + sizeof(Recode) * num;
+size_t Transaction::getSize(size_t num, size_t sessions) {
+    return sizeof(Transaction) + sizeof(Recode) * num + sizeof(Session) * sessions;
 }
 
 /**************************************************************************//**
@@ -83,6 +106,8 @@ Transaction& Transaction::getTrans() {
 *            name      :    管理情報名称         [入力]
 *            file      :    ロックファイル名称   [入力]
 *            num       :    管理情報数           [入力]
+*            threshold :    自動GCのリング使用率しきい値(%) [入力]
+*            sessions  :    セッション数         [入力]
 *
 *    ３    戻り値
 *            メモリサイズ(byte)
@@ -91,13 +116,276 @@ Transaction& Transaction::getTrans() {
 *            REV001 : 新規作成
 * </pre>
 **//**************************************************************************/
-void Transaction::init(const string& name, const msec_t timeOut, const size_t num) {
-    Header::init(name, timeOut, num, getSize(num), sizeof(Recode));
-    trid_next = trid_collecting = TRID_MIN;
-    // インデックスルートの初期化
-    index_root_master = ::Entity::INVALID_ROWID;
+void Transaction::init(const string& name, const msec_t timeOut, const size_t num,
+        const uint32_t threshold, const size_t sessions) {
+    // ヒントビットのTRCCは下位32ビットの差で比較するため
+    if(num >= (1uL << 31))
+        OUT_OF_RANGE("トランザクション管理配列数が大きすぎます MaxLine:" << num);
+    // セッション番号は予約印の下位32ビットに収める
+    if(sessions == 0 || sessions >= (1uL << 31))
+        OUT_OF_RANGE("セッション管理配列数が不正です MaxSession:" << sessions);
+#ifdef PTHREAD_MUTEX
+    // 共有メモリ内ロックは共有ロックの保持をセッション毎に記録する
+    if(sessions > SharedLock::MAX_SESSION)
+        OUT_OF_RANGE("セッション管理配列数が大きすぎます MaxSession:" << sessions
+                << " 上限:" << SharedLock::MAX_SESSION);
+#endif
+    Header::init(name, timeOut, num, getSize(num, sessions), sizeof(Recode));
+    trid_next.store(TRID_MIN);
+    trid_collecting.store(TRID_MIN);
     // トランザクションコミットカウントの初期化
-    trcc_next = TRCC_MIN;
+    trcc_issue.store(TRCC_MIN);
+    trcc_next.store(TRCC_MIN);
+    state_seq.store(0);
+    state_waiters.store(0);
+    // 自動GC
+    gc_seq.store(0);
+    gc_pending.store(0);
+    gc_waiters.store(0);
+    gc_workers.store(0);
+    gc_requests.store(0);
+    gc_cycle_seq.store(0);
+    gc_cycle_owner.store(SESSION_NONE);
+    gc_cycle_time.store(0);
+    session_reclaimed.store(0);
+    gc_threshold = threshold;
+    // 管理配列は未割当て(TRID_MAX)にしておく
+    for(size_t i = 0; i < num; i++) {
+        tag_transaction[i].trid.store(TRID_MAX);
+        tag_transaction[i].status.store(ABORTED);
+        tag_transaction[i].waiters.store(0);
+        tag_transaction[i].session = SESSION_NONE;
+        tag_transaction[i].ticket.store(TRCC_MAX);
+    }
+    // セッション管理配列は全て空きにしておく
+    max_session = static_cast<uint32_t>(sessions);
+    pthread_mutexattr_t attr;
+    if(::pthread_mutexattr_init(&attr) != 0)
+        LOCK_FAILED("ミューテックス属性の初期化に失敗しました");
+    ::pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    ::pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    for(size_t i = 0; i < sessions; i++) {
+        Session& ses = getSession(i);
+        ses.state.store(SESSION_FREE);
+        ses.generation.store(0);
+        ses.pid = 0;
+        ses.pid_time = -1;
+        int ret = ::pthread_mutex_init(&ses.alive, &attr);
+        if(ret != 0) {
+            ::pthread_mutexattr_destroy(&attr);
+            LOCK_FAILED("ミューテックスの初期化に失敗しました:" << ret);
+        }
+    }
+    ::pthread_mutexattr_destroy(&attr);
+    // 自プロセスの登録は作り直した配列では無効
+    reset_session();
+}
+
+/**************************************************************************//**
+*
+*     関数名：セッション登録 (attachSession)
+* <pre>
+*
+*    １    機能
+*            自プロセスにセッションを割り当て、PIDと開始時間を記録する。
+*            登録済みであれば登録済みのセッションを返す。
+*            呼び出したスレッドは解除までセッションのミューテックスを保持
+*            するため、アタッチ中存続するスレッドから呼び出すこと。
+*            空きがなければ終了プロセスのセッションを回収して再試行する
+*
+*    ２    引数
+*            なし
+*
+*    ３    戻り値
+*            セッション識別子
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+session_t Transaction::attachSession() {
+    session_t key = self_session.load(::std::memory_order_acquire);
+    if(key != SESSION_NONE) return key;
+
+    ::std::lock_guard<::std::mutex> guard(session_mutex);
+    key = self_session.load(::std::memory_order_acquire);
+    if(key != SESSION_NONE) return key;
+    static const int forked = ::pthread_atfork(nullptr, nullptr, reset_session);
+    (void)forked;
+
+    // 開始時間の採取は登録時の1回のみ
+    const pid_t pid = ::getpid();
+    const time_t time = Initializer::getProcTime(pid);
+    for(int retry = 0; retry < 2; retry++) {
+        for(uint32_t i = 0; i < max_session; i++) {
+            Session& ses = getSession(i);
+            uint32_t state = SESSION_FREE;
+            if(!ses.state.compare_exchange_strong(state, SESSION_ATTACHING))
+                continue;
+            // 前の登録スレッドが保持したままなら使わない
+            int ret = ::pthread_mutex_trylock(&ses.alive);
+            if(ret == EOWNERDEAD) ret = ::pthread_mutex_consistent(&ses.alive);
+            if(ret != 0) {
+                ses.state.store(SESSION_FREE);
+                continue;
+            }
+            ses.pid = pid;
+            ses.pid_time = time;
+            const uint32_t gen = ses.generation.fetch_add(1) + 1;
+            ses.state.store(SESSION_ACTIVE, ::std::memory_order_release);
+
+            key = (static_cast<session_t>(gen & SESSION_GEN_MASK) << 32) | i;
+            self_session.store(key, ::std::memory_order_release);
+            TRACE_LOG("セッション登録 session:" << i << " pid:" << pid);
+            return key;
+        }
+        if(checkSessions() == 0) break;
+    }
+    MEMORYFULL("セッション管理配列に空きがありません MaxSession:" << max_session);
+}
+
+/**************************************************************************//**
+*
+*     関数名：セッション解除 (detachSession)
+* <pre>
+*
+*    １    機能
+*            自プロセスのセッションを解除して空きに戻す。
+*            未登録であれば何もしない
+*
+*    ２    引数
+*            なし
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void Transaction::detachSession() {
+    ::std::lock_guard<::std::mutex> guard(session_mutex);
+    const session_t key = self_session.exchange(SESSION_NONE);
+    if(key == SESSION_NONE) return;
+
+    Session& ses = getSession(key & 0xFFFFFFFF);
+    if((ses.generation.load() & SESSION_GEN_MASK) != (key >> 32)) return;
+    // 登録スレッド以外からの解除は失敗するが、そのスレッドの終了時に
+    // EOWNERDEADとなり次の登録で使われる
+    ::pthread_mutex_unlock(&ses.alive);
+    uint32_t state = SESSION_ACTIVE;
+    ses.state.compare_exchange_strong(state, SESSION_FREE);
+    TRACE_LOG("セッション解除 session:" << (key & 0xFFFFFFFF));
+}
+
+/**************************************************************************//**
+*
+*     関数名：終了プロセスのセッション回収 (checkSessions)
+* <pre>
+*
+*    １    機能
+*            使用中のセッションを全て確認し、登録プロセスが終了したものを
+*            空きに戻す。ミューテックスが保持されていれば生存とみなし、
+*            保持者がいない(登録スレッドが終了した)場合のみプロセスの
+*            開始時間で生存を確認する。
+*            回収するセッションが保持していた共有ロックは、再登録される
+*            前(ミューテックス保持中)に全管理領域で開放する。
+*            処理量はセッション数に比例し、Tr数によらない
+*
+*    ２    引数
+*            なし
+*
+*    ３    戻り値
+*            回収したセッション数
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+size_t Transaction::checkSessions() {
+    size_t ret = 0;
+    for(uint32_t i = 0; i < max_session; i++) {
+        Session& ses = getSession(i);
+        if(ses.state.load(::std::memory_order_acquire) != SESSION_ACTIVE) continue;
+
+        int lock = ::pthread_mutex_trylock(&ses.alive);
+        // 登録スレッドが保持中
+        if(lock == EBUSY) continue;
+        if(lock == EOWNERDEAD) lock = ::pthread_mutex_consistent(&ses.alive);
+        if(lock != 0) {
+            WARN_LOG("セッションの確認に失敗しました session:" << i << " ret:" << lock);
+            continue;
+        }
+        // 保持中は同じセッションに登録されないため、状態の変更までを保持中に行う
+        const time_t time = Initializer::getProcTime(ses.pid);
+        if(time == -1 || time != ses.pid_time) {
+            uint32_t state = SESSION_ACTIVE;
+            if(ses.state.compare_exchange_strong(state, SESSION_FREE)) {
+                WARN_LOG("終了プロセスのセッションを回収しました session:" << i
+                        << " pid:" << ses.pid);
+                releaseSession(i);
+                for(auto it = Initializer::table_map.begin();
+                        it != Initializer::table_map.end(); it++) {
+                    if(it->second != nullptr) it->second->releaseSession(i);
+                }
+                // 予約した要素はロック中の場合があるため、GCが回収する
+                session_reclaimed.fetch_add(1);
+                ret++;
+            }
+        }
+        ::pthread_mutex_unlock(&ses.alive);
+    }
+    return ret;
+}
+
+/**************************************************************************//**
+*
+*     関数名：自プロセスのセッション取得 (getSelfSession)
+* <pre>
+*
+*    １    機能
+*            登録済みの自プロセスのセッションを取得する。登録はしない
+*
+*    ２    引数
+*            なし
+*
+*    ３    戻り値
+*            セッション識別子(未登録はSESSION_NONE)
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+session_t Transaction::getSelfSession() {
+    return self_session.load(::std::memory_order_acquire);
+}
+
+/**************************************************************************//**
+*
+*     関数名：セッション生存判定 (isSessionAlive)
+* <pre>
+*
+*    １    機能
+*            セッションが使用中で、登録時から割り当て直されていないか
+*            判定する。システムコールは発行しない
+*
+*    ２    引数
+*            key       :    セッション識別子     [入力]
+*
+*    ３    戻り値
+*            true  : 生存
+*            false : 解除・回収済み
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+bool Transaction::isSessionAlive(session_t key) const {
+    const size_t index = key & 0xFFFFFFFF;
+    if(key == SESSION_NONE || index >= max_session) return false;
+    const Session& ses = getSession(index);
+    return ses.state.load(::std::memory_order_acquire) == SESSION_ACTIVE
+            && (ses.generation.load() & SESSION_GEN_MASK) == (key >> 32);
 }
 
 /**************************************************************************//**
@@ -119,14 +407,41 @@ void Transaction::init(const string& name, const msec_t timeOut, const size_t nu
 * </pre>
 **//**************************************************************************/
 Transaction::Recode& Transaction::getTransaction(trid_t trid) {
-    if(this->trid_collecting > trid || trid >= this->trid_next)
+    trid_t collecting = this->trid_collecting.load(::std::memory_order_acquire);
+    trid_t next = this->trid_next.load(::std::memory_order_acquire);
+    if(collecting > trid || trid >= next)
         OUT_OF_RANGE("トランザクション情報が有効範囲外です trid:" << trid <<
-                " collecting:" << this->trid_collecting <<
-                " next:" << this->trid_next);
+                " collecting:" << collecting << " next:" << next);
 
     return this->tag_transaction[trid % this->getMaxLine()];
 }
 
+/**************************************************************************//**
+*
+*     関数名：トランザクション状態取得 (getStatus)
+* <pre>
+*
+*    １    機能
+*            トランザクション状態を取得する。
+*            TRIDの払い出し後、管理情報の公開前であれば処理中とみなす
+*
+*    ２    引数
+*            trid      :    トランザクションID   [入力]
+*
+*    ３    戻り値
+*            トランザクション状態
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+Transaction::Status Transaction::getStatus(trid_t trid) {
+    Recode& tr = getTransaction(trid);
+    // リングの前周の情報が残っている間は公開前
+    if(tr.trid.load(::std::memory_order_acquire) != trid) return IN_PROGRESS;
+    return tr.status.load(::std::memory_order_acquire);
+}
+
 /**************************************************************************//**
 *
 *     関数名：トランザクション開始
@@ -134,7 +449,8 @@ Transaction::Recode& Transaction::getTransaction(trid_t trid) {
 *
 *    １    機能
 *            次回取得トランザクションIDをインクリメントして、
-*            トランザクション情報を取得する
+*            トランザクション情報を取得する。
+*            実行プロセスは登録済みのセッションで記録する
 *
 *    ２    引数
 *            なし
@@ -147,27 +463,214 @@ Transaction::Recode& Transaction::getTransaction(trid_t trid) {
 * </pre>
 **//**************************************************************************/
 trid_t Transaction::startTr() {
-    trid_t trid = this->trid_next++;
-    Recode& tr = getTransaction(trid);
-    // 自プロセスのPID保存
-    tr.pid = ::getpid();
-    // 自プロセスの開始時間保存
-    tr.pid_time = Initializer::getProcTime(tr.pid);
-    // トランザクションを処理中に設定
-    tr.status = IN_PROGRESS;
+    // 未登録であればここで登録する(以降はシステムコールなし)
+    const session_t session = attachSession();
+    trid_t trid = this->trid_next.load();
+    do {
+        // collectingとnextの差がmax_line以上ならリングに空きがない
+        // (GCを要求して呼出し元で空きを待ち合わせる)
+        if(trid - this->trid_collecting.load() >= this->getMaxLine()) {
+            requestGC();
+            return TRID_MAX;
+        }
+    } while(!this->trid_next.compare_exchange_weak(trid, trid + 1));
 
-    TRACE_LOG("LOAD Index Root Master (trid:" << trid << ")"
-            " MASTERroot:" << this->index_root_master <<
-            " -> TRNroot:" << tr.index_root);
+    Recode& tr = this->tag_transaction[trid % this->getMaxLine()];
+    // 自プロセスのセッション保存
+    tr.session = session;
+    tr.trid_end.store(TRID_MAX, ::std::memory_order_relaxed);
+    tr.ticket.store(TRCC_MAX, ::std::memory_order_relaxed);
+    // トランザクションを処理中に設定
+    tr.status.store(IN_PROGRESS, ::std::memory_order_relaxed);
 
-    // TODO(インデックスルートはここで設定する)
-    tr.index_root = this->index_root_master;
     // TRCC現在値の保存
-    tr.trcc_begin = this->trcc_next;
+    // trid_nextの更新後に読む(コミット側は公開後にtrid_nextを読むため、
+    // 公開前のTRCCを読んだTrは必ずコミットしたTrのtrid_end未満となる)
+    tr.trcc_begin = this->trcc_next.load();
+
+    // 管理情報を公開する
+    tr.trid.store(trid, ::std::memory_order_release);
+
+    // リング使用率がしきい値を超えたらGCを要求する
+    if(gc_threshold != 0 && getRingPercent() >= gc_threshold) requestGC();
 
     return trid;
 }
 
+/**************************************************************************//**
+*
+*     関数名：待ち合わせ対象トランザクション記録 (setBlocker)
+* <pre>
+*
+*    １    機能
+*            書込み不可の原因となったトランザクションを記録する。
+*            処理中のトランザクションのみ記録し、それ以外は記録を消す
+*
+*    ２    引数
+*            trid      :    原因のトランザクションID   [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void Transaction::setBlocker(trid_t trid) {
+    Transaction& trn = getTrans();
+    blocker_trid = TRID_MAX;
+    if(trid < trn.trid_collecting.load() || trn.trid_next.load() <= trid) return;
+
+    Recode& tr = trn.tag_transaction[trid % trn.getMaxLine()];
+    if(tr.trid.load() == trid && tr.status.load() == IN_PROGRESS)
+        blocker_trid = trid;
+}
+
+/**************************************************************************//**
+*
+*     関数名：トランザクション終了待ち合わせ (waitTr)
+* <pre>
+*
+*    １    機能
+*            setBlockerで記録したトランザクションの終了をfutexで待ち合わせる。
+*            記録がない場合(原因のTrが終了済み・リング満杯等)は、いずれかの
+*            トランザクションの状態変化を待ち合わせる。
+*            起床・タイムアウトのいずれでも復帰するので、呼出し元で再試行
+*            と期限の判定を行うこと
+*
+*    ２    引数
+*            msec      :    最大待ち時間(ms) 0は無制限   [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void Transaction::waitTr(msec_t msec) {
+    trid_t trid = blocker_trid;
+    blocker_trid = TRID_MAX;
+    // 状態変化通番は判定より先に取得し、取りこぼしを防ぐ
+    uint32_t seq = state_seq.load();
+
+    if(trid != TRID_MAX) {
+        Recode& tr = tag_transaction[trid % getMaxLine()];
+        tr.waiters.fetch_add(1);
+        // 記録後に終了していれば待たずに再試行させる
+        bool running = tr.trid.load() == trid && tr.status.load() == IN_PROGRESS;
+        if(running) Futex::wait(tr.status, IN_PROGRESS, msec);
+        tr.waiters.fetch_sub(1);
+        return;
+    }
+
+    state_waiters.fetch_add(1);
+    Futex::wait(state_seq, seq, msec);
+    state_waiters.fetch_sub(1);
+}
+
+/**************************************************************************//**
+*
+*     関数名：トランザクション終了通知 (notifyEnd)
+* <pre>
+*
+*    １    機能
+*            トランザクションの終了(コミット・アボート)を待ち合わせている
+*            プロセスを起床する。状態の更新後に呼び出すこと
+*
+*    ２    引数
+*            tr        :    終了したトランザクション管理情報   [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void Transaction::notifyEnd(Recode& tr) {
+    if(tr.waiters.load() != 0) Futex::wake(tr.status);
+    notifyState();
+}
+
+/**************************************************************************//**
+*
+*     関数名：GC要求 (requestGC)
+* <pre>
+*
+*    １    機能
+*            GC要求中にし、常駐GCを起床する。既に要求中なら何もしない
+*            (要求はGCのサイクル開始で解除する)
+*
+*    ２    引数
+*            なし
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void Transaction::requestGC() {
+    if(gc_pending.load(::std::memory_order_relaxed) != 0
+            || gc_pending.exchange(1) != 0) return;
+    gc_requests.fetch_add(1);
+    gc_seq.fetch_add(1);
+    if(gc_waiters.load() != 0) Futex::wake(gc_seq);
+}
+
+/**************************************************************************//**
+*
+*     関数名：GC要求待ち合わせ (waitGC)
+* <pre>
+*
+*    １    機能
+*            常駐GCがGC要求を待ち合わせる。要求中なら待たずに復帰する。
+*            起床・タイムアウトのいずれでも復帰する
+*
+*    ２    引数
+*            msec      :    最大待ち時間(ms) 0は無制限   [入力]
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void Transaction::waitGC(msec_t msec) {
+    // 通番は判定より先に取得し、取りこぼしを防ぐ
+    uint32_t seq = gc_seq.load();
+    if(gc_pending.load() != 0) return;
+    gc_waiters.fetch_add(1);
+    Futex::wait(gc_seq, seq, msec);
+    gc_waiters.fetch_sub(1);
+}
+
+/**************************************************************************//**
+*
+*     関数名：状態変化通知 (notifyState)
+* <pre>
+*
+*    １    機能
+*            状態変化通番を進め、待ち合わせているプロセスを起床する
+*
+*    ２    引数
+*            なし
+*
+*    ３    戻り値
+*            なし
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+void Transaction::notifyState() {
+    state_seq.fetch_add(1);
+    if(state_waiters.load() != 0) Futex::wake(state_seq);
+}
+
 /**************************************************************************//**
 *
 *     関数名：トランザクションコミット
@@ -175,7 +678,12 @@ trid_t Transaction::startTr() {
 *
 *    １    機能
 *            トランザクション情報にCOMMITEDを設定して
-*            トランザクションを確定する
+*            トランザクションを確定する。
+*            TRCCは払い出し順に公開するため、先に払い出されたコミットの公開を
+*            待つ。一定時間公開されなければ、払い出し先のプロセスが終了して
+*            いないか確認し、終了していれば代わりに公開する。
+*            trid_endは公開後のtrid_nextとする。公開前に開始したTrは全て
+*            trid_end未満となり、GCは設定されるまで回収しない
 *
 *    ２    引数
 *             trid : トランザクションID
@@ -189,18 +697,35 @@ trid_t Transaction::startTr() {
 **//**************************************************************************/
 void Transaction::commitTr(trid_t trid) {
     Recode& tr = this->getTransaction(trid);
-    // トランザクション完了時のtrid_nextを保存
-    tr.trid_end = this->trid_next;
-    // トランザクションをコミット状態にする
-    tr.status = COMMITTED;
-    // TODO(次に生成されるTrから可視なindex_rootであれば全体に反映する)
-    if(IndexManager::is_index_root_valid(trid, tr.index_root)) {
-        TRACE_LOG("CommitTr(trid:" << trid <<") TRNroot:" << tr.index_root <<
-                " -> MASTERroot:" << this->index_root_master);
-        this->index_root_master = tr.index_root;
+    // 払い出し中を記録してからTRCCを払い出し、トランザクションをコミット状態にする
+    // 公開(trcc_next)前なので、他Trからはまだ不可視
+    tr.ticket.store(TICKET_PENDING);
+    trcc_t trcc = this->trcc_issue.fetch_add(1);
+    tr.ticket.store(trcc);
+    tr.trcc_end = trcc;
+    tr.status.store(COMMITTED);
+
+    // 先に払い出されたコミットの公開を待つ
+    uint64_t deadline = 0;
+    for(trcc_t next = this->trcc_next.load(::std::memory_order_acquire); next != trcc;
+            next = this->trcc_next.load(::std::memory_order_acquire)) {
+        const uint64_t now = msecNow();
+        if(deadline == 0) {
+            deadline = now + PUBLISH_RECOVER_MSEC;
+        } else if(now >= deadline) {
+            recoverTicket(next);
+            deadline = now + PUBLISH_RECOVER_MSEC;
+        }
+        ::sched_yield();
     }
-    // トランザクションコミットカウントをすすめる
-    tr.trcc_end = trcc_next++;
+
+    // TRCCを公開する
+    this->trcc_next.store(trcc + 1);
+    // 公開後のtrid_nextを保存(公開前のTRCCを読んだTrはこれ未満となる)
+    tr.trid_end.store(this->trid_next.load());
+
+    // 終了待ちのトランザクションを起床する
+    notifyEnd(tr);
 }
 
 /**************************************************************************//**
@@ -225,9 +750,61 @@ void Transaction::commitTr(trid_t trid) {
 void Transaction::abortTr(trid_t trid) {
     Recode& tr = getTransaction(trid);
     // トランザクション完了時のtrid_nextを保存
-    tr.trid_end = trid_next;
+    tr.trid_end.store(trid_next.load());
     // トランザクションをアボート状態にする
-    tr.status = ABORTED;
+    tr.status.store(ABORTED);
+    // 終了待ちのトランザクションを起床する
+    notifyEnd(tr);
+}
+
+/**************************************************************************//**
+*
+*     関数名：終了したプロセスのTRCC公開 (recoverTicket)
+* <pre>
+*
+*    １    機能
+*            公開待ちのTRCCの払い出し先が終了していれば、代わりに公開する。
+*            払い出し先はticketで特定する。払い出しを記録する前に終了した
+*            場合は特定できないため、払い出し中のTrが全て終了していれば
+*            その中に払い出し先があるとみなす。
+*            払い出し先が生存している(または生存している払い出し中のTrが
+*            ある)場合は何もしない
+*
+*    ２    引数
+*             trcc : 公開待ちのTRCC
+*
+*    ３    戻り値
+*             true  : 代わりに公開した
+*             false : 公開しない
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+bool Transaction::recoverTicket(trcc_t trcc) {
+    checkSessions();
+
+    Recode* owner = nullptr;
+    bool pending = false;
+    const trid_t next = trid_next.load();
+    for(trid_t trid = trid_collecting.load(); trid < next; trid++) {
+        Recode& tr = tag_transaction[trid % getMaxLine()];
+        if(tr.trid.load(::std::memory_order_acquire) != trid) continue;
+        const trcc_t ticket = tr.ticket.load();
+        if(ticket != trcc && ticket != TICKET_PENDING) continue;
+        // 払い出し先(またはその候補)が生存していれば待つ
+        if(isSessionAlive(tr.session)) return false;
+        if(ticket == trcc) owner = &tr;
+        else pending = true;
+    }
+    if(owner == nullptr && !pending) return false;
+
+    trcc_t expected = trcc;
+    if(!trcc_next.compare_exchange_strong(expected, trcc + 1)) return false;
+    WARN_LOG("終了プロセスのコミットを公開しました trcc:" << trcc);
+    // 払い出し先のTrの終了待ちを起床する
+    if(owner != nullptr) notifyEnd(*owner);
+    return true;
 }
 
 /**************************************************************************//**
@@ -241,6 +818,8 @@ void Transaction::abortTr(trid_t trid) {
 *    ２    引数
 *            self_trid    : 現在のトランザクションID
 *            target_trid  : 対象のトランザクションID
+*            status       : 確定した対象Trの状態(未確定はIN_PROGRESS) [出力]
+*            trcc_end     : 対象TrのコミットTRCC(COMMITTEDのみ)       [出力]
 *
 *    ３    戻り値
 *            true  : 取得可能
@@ -250,29 +829,74 @@ void Transaction::abortTr(trid_t trid) {
 *            REV001 : 新規作成
 * </pre>
 **//**************************************************************************/
-bool Transaction::is_tr_valid_to_read(trid_t trid, trid_t tgtTrid) {
+bool Transaction::is_tr_valid_to_read(trid_t trid, trid_t tgtTrid,
+        Status* status, trcc_t* trccEnd) {
+    if(status != nullptr) *status = IN_PROGRESS;
     // 自身のTRIDが対象ならば取得可能
     if(tgtTrid == trid) return true;
 
     Transaction& trn = Transaction::getTrans();
 
     // 回収済みのTRIDは全てコミット扱いなので取得可能
-    if(tgtTrid < trn.trid_collecting) return true;
+    if(tgtTrid < trn.trid_collecting.load()) return true;
     // 未来のTRID(TRID_MAXを含む)は存在しないので取得不能
-    if(trn.trid_next <= tgtTrid) return false;
+    trid_t next = trn.trid_next.load();
+    if(next <= tgtTrid) return false;
 
     // 対象TrIDに対応するトランザクション管理情報取得
     Recode& tr = trn.getTransaction(tgtTrid);
     // 対象TrIDが可視範囲外ならtrcc_end = TRCC_MIN status = COMMITTEDと扱う
+    // 状態を先に読み、コミット済みの場合のみtrcc_endを参照する
+    Status sts = trn.getStatus(tgtTrid);
+    if(status != nullptr) *status = sts;
+    if(sts != COMMITTED) return false;
+    if(trccEnd != nullptr) *trccEnd = tr.trcc_end;
 
     trcc_t trcc_begin = TRCC_MAX;
-    if (trn.trid_next > trid) {
+    if (next > trid) {
         // 自TrIDに対応するトランザクション管理情報取得
         Recode& self_tr = trn.getTransaction(trid);
         trcc_begin = self_tr.trcc_begin;
     }
-    // 対象Trがコミットで対象Trのtrcc_endよりも自trcc_beginの方が後なら可視
-    return tr.status == COMMITTED && tr.trcc_end < trcc_begin;
+    // 対象Trのtrcc_endよりも自trcc_beginの方が後なら可視
+    return tr.trcc_end < trcc_begin;
+}
+
+/**************************************************************************//**
+*
+*     関数名：コミット済みトランザクション可視判定 (is_trcc_visible)
+* <pre>
+*
+*    １    機能
+*            コミット済みと分かっているトランザクションが読込み可能かを、
+*            ヒントビットに記録したコミットTRCCで判定する。
+*            未回収のTrのTRCCの差はトランザクション管理配列数未満のため、
+*            下位32ビットの差で比較する
+*
+*    ２    引数
+*            self_trid    : 現在のトランザクションID
+*            target_trid  : 対象のトランザクションID
+*            trcc_end     : 対象TrのコミットTRCC(下位32ビット)
+*
+*    ３    戻り値
+*            true  : 取得可能
+*            false : 取得不能
+*
+*    ４    履歴
+*            REV001 : 新規作成
+* </pre>
+**//**************************************************************************/
+bool Transaction::is_trcc_visible(trid_t trid, trid_t tgtTrid, uint32_t trccEnd) {
+    Transaction& trn = Transaction::getTrans();
+
+    // 回収済みのTRIDは全てコミット扱いなので取得可能
+    if(tgtTrid < trn.trid_collecting.load()) return true;
+    // 自TrIDが無効なら全てのコミットが可視
+    if(trn.trid_next.load() <= trid) return true;
+
+    // 対象Trのtrcc_endよりも自trcc_beginの方が後なら可視
+    uint32_t trccBegin = static_cast<uint32_t>(trn.getTransaction(trid).trcc_begin);
+    return static_cast<int32_t>(trccEnd - trccBegin) < 0;
 }
 
 /**************************************************************************//**
@@ -302,15 +926,15 @@ bool Transaction::is_tr_valid_to_write(trid_t trid, trid_t tgtTrid, target_trid_
     // 自身のTRIDが書いたTrIDなら無効
     if(tgtTrid == trid) return false;
     // 回収済みのTRIDで、調査対象がxmaxなら有効、lockは無効
-    if(tgtTrid < trn.trid_collecting) return sts == IS_XMAX;
+    if(tgtTrid < trn.trid_collecting.load()) return sts == IS_XMAX;
     // 未来のTrID(TRID_MAXを含む)なら無効
-    if(trn.trid_next <= tgtTrid) return false;
-    // 対象トランザクション情報取得
-    Recode& tr = trn.getTransaction(tgtTrid);
+    if(trn.trid_next.load() <= tgtTrid) return false;
+    // 対象トランザクション状態取得
+    Status status = trn.getStatus(tgtTrid);
     // TODO(処理中のxmax/lockの指すTrIDは有効)
-    if(tr.status == IN_PROGRESS) return true;
+    if(status == IN_PROGRESS) return true;
     // 対象がxmaxでCOMMITなら有効
-    return (tr.status == COMMITTED && sts == IS_XMAX);
+    return (status == COMMITTED && sts == IS_XMAX);
     // 対象がlockなら無効。xmaxでもコミット以外なら無効
 }
 
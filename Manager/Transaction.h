@@ -15,7 +15,11 @@
 #define SHAREDMEMORY_TRANSACTION_H_
 
 #include <Manager/Header.h>
+#include <pthread.h>
 #include <unistd.h>
+
+#include <atomic>
+
 #include "inc/SHMConst.h"
 
 namespace SharedMemory
@@ -28,6 +32,11 @@ typedef uint64_t trcc_t;    ///< Trコミットカウント(TRCC)型(64ビット
 static const trcc_t  TRCC_MAX = ~0uL;     ///< TRCC 最大値
 static const trcc_t  TRCC_MIN =  0uL;     ///< TRCC 最小値
 
+static const size_t  CACHE_LINE = 64;     ///< キャッシュラインサイズ(byte)
+
+typedef uint64_t session_t; ///< セッション識別子型(上位32ビット=世代、下位=番号)
+static const session_t SESSION_NONE = ~0uL;   ///< セッションなし
+
 /**************************************************************************//**
 *
 *     クラス名：共通メモリ管理機能 全体管理領域（全体トランザクション管理領域）
@@ -43,11 +52,26 @@ static const trcc_t  TRCC_MIN =  0uL;     ///< TRCC 最小値
 **//**************************************************************************/
 class Transaction : public Header {
 public:
-
-    trid_t trid_next;           ///< 次のTRID
-    trid_t trid_collecting;     ///< 最古の未回収TRID
-    trcc_t trcc_next;           ///< 次のTRCC
-    ::Entity::rowid_t index_root_master;  ///< インデックスルートマスタ
+    // 各カウンタはプロセス間で競合するため個別のキャッシュラインに置く
+    alignas(CACHE_LINE) ::std::atomic<trid_t> trid_next;       ///< 次のTRID
+    alignas(CACHE_LINE) ::std::atomic<trid_t> trid_collecting; ///< 最古の未回収TRID
+    alignas(CACHE_LINE) ::std::atomic<trcc_t> trcc_issue;      ///< 次に払い出すTRCC
+    alignas(CACHE_LINE) ::std::atomic<trcc_t> trcc_next;       ///< 次のTRCC(公開済み)
+    alignas(CACHE_LINE) ::std::atomic<uint32_t> state_seq;     ///< 状態変化通番(futexワード)
+    ::std::atomic<uint32_t> state_waiters;  ///< 状態変化の待ち合わせ数
+    alignas(CACHE_LINE) ::std::atomic<uint32_t> gc_seq;        ///< GC要求通番(futexワード)
+    ::std::atomic<uint32_t> gc_pending;     ///< GC要求中(サイクル開始で解除)
+    ::std::atomic<uint32_t> gc_waiters;     ///< GC要求の待ち合わせ数
+    ::std::atomic<uint32_t> gc_workers;     ///< 常駐GC数
+    ::std::atomic<uint64_t> gc_requests;    ///< GC要求回数(累計)
+    ::std::atomic<uint64_t> gc_cycle_seq;   ///< GCサイクル通番(サイクル開始毎に加算)
+    ::std::atomic<session_t> gc_cycle_owner;///< サイクル実行中のセッション(SESSION_NONEはなし)
+    ::std::atomic<uint64_t> gc_cycle_time;  ///< サイクルの最終進捗時刻(μs、単調増加時刻)
+    ::std::atomic<uint64_t> session_reclaimed;  ///< 回収したセッション数(累計)
+                                            // GCは変化した場合のみ予約を回収する
+    uint32_t gc_threshold;                  ///< 自動GCのリング使用率しきい値(%)
+                                            // 0は自動GCなし
+    uint32_t max_session;                   ///< セッション管理配列数
 
     /**********************************************************************//**
     *     構造体名：共通メモリ管理機能 全体トランザクション管理情報定義
@@ -55,35 +79,140 @@ public:
     enum Status { IN_PROGRESS, COMMITTED, ABORTED };
     class Recode {
     public:
-        trid_t trid_end;        ///< Tr終了時のTRID現在値
+        ::std::atomic<trid_t> trid;     ///< 割当て済みTRID(公開判定用)
+        ::std::atomic<trid_t> trid_end; ///< Tr終了時のTRID現在値
+                                        // TRID_MAXはコミットの公開前(GCの回収対象外)
         trcc_t trcc_begin;      ///< 処理開始時のTRCC現在値
         trcc_t trcc_end;        ///< コミット時のTRCC現在値
-        Status status;          ///< トランザクション状態
-        pid_t  pid;             ///< Tr実行プロセスのPID
-        time_t pid_time;        ///< Tr実行プロセスの開始時間
-        ::Entity::rowid_t  index_root;    ///< インデックス管理テーブルの基底
+        ::std::atomic<Status> status;   ///< トランザクション状態(futexワード)
+        ::std::atomic<uint32_t> waiters;    ///< 終了待ち合わせ数
+        session_t session;      ///< Tr実行プロセスのセッション
+        ::std::atomic<trcc_t> ticket;   ///< 払い出されたTRCC(公開待ちの回収用)
+                                        // TRCC_MAXは払い出し前、TICKET_PENDINGは払い出し中
+    };
+    alignas(CACHE_LINE) Recode tag_transaction[0];    ///< トランザクション管理配列
+    // セッション管理配列(Session × max_session)はトランザクション管理配列に続く
+
+    /**********************************************************************//**
+    *     構造体名：共通メモリ管理機能 セッション管理情報定義
+    *     アタッチしたプロセス毎に1つ割り当て、PIDと開始時間を登録時に
+    *     1度だけ記録する。登録したスレッドがaliveを保持し続けるため、
+    *     保持者の異常終了はロバストミューテックスのEOWNERDEADで検出する
+    **//**********************************************************************/
+    enum SessionState { SESSION_FREE, SESSION_ATTACHING, SESSION_ACTIVE };
+    class Session {
+    public:
+        ::std::atomic<uint32_t> state;      ///< セッション状態
+        ::std::atomic<uint32_t> generation; ///< 世代(割当て毎に加算)
+        pid_t  pid;             ///< 登録プロセスのPID
+        time_t pid_time;        ///< 登録プロセスの開始時間
+        pthread_mutex_t alive;  ///< 生存確認用ミューテックス(登録スレッドが保持)
     };
-    Recode tag_transaction[0];    ///< トランザクション管理配列
 
     static const ::std::string TRANSACTION_NAME;
+    /// 自動GCのリング使用率しきい値の省略値(%)
+    static const uint32_t DEFAULT_GC_THRESHOLD = 75;
+    /// セッション管理配列数の省略値
+    static const size_t DEFAULT_MAX_SESSION = 256;
+    /// 払い出し中のTRCC(Recode::ticket)
+    static const trcc_t TICKET_PENDING = TRCC_MAX - 1;
+    /// コミットの公開待ちで、払い出し先の終了を確認する間隔(ms)
+    static const uint64_t PUBLISH_RECOVER_MSEC = 1000;
+    /// セッション識別子の世代のマスク(予約印に収まる31ビット)
+    static const uint32_t SESSION_GEN_MASK = 0x7FFFFFFF;
 
 public:
     /// サイズ取得
-    static size_t getSize(size_t);
+    static size_t getSize(size_t, size_t = DEFAULT_MAX_SESSION);
     /// 全体トランザクション管理情報取得
     static Transaction& getTrans();
     /// 初期化
-    void init(const ::std::string&, const msec_t, const size_t);
+    void init(const ::std::string&, const msec_t, const size_t,
+            const uint32_t = DEFAULT_GC_THRESHOLD,
+            const size_t = DEFAULT_MAX_SESSION);
+    /// セッション登録
+    session_t attachSession();
+    /// セッション解除
+    void detachSession();
+    /// 終了プロセスのセッション回収
+    size_t checkSessions();
+    /// セッション生存判定
+    bool isSessionAlive(session_t) const;
+    /// 自プロセスのセッション取得
+    static session_t getSelfSession();
+
+    /**********************************************************************//**
+    *   関数名 : セッション管理情報取得(getSession)
+    *   引数   : index : セッション番号       [入力]
+    *   戻り値 : セッション管理情報
+    **//*********************************************************************/
+    inline Session& getSession(size_t index) {
+        return reinterpret_cast<Session*>(tag_transaction + getMaxLine())[index];
+    }
+    inline const Session& getSession(size_t index) const {
+        return reinterpret_cast<const Session*>(tag_transaction + getMaxLine())[index];
+    }
     /// トランザクション管理情報アドレス取得
     Recode& getTransaction(trid_t);
+    /// トランザクション状態取得
+    Status getStatus(trid_t);
     /// トランザクション開始
     trid_t startTr();
+    /// 待ち合わせ対象トランザクション記録
+    static void setBlocker(trid_t);
+    /// トランザクション終了待ち合わせ
+    void waitTr(msec_t);
+    /// トランザクション終了通知
+    void notifyEnd(Recode&);
+    /// 状態変化通知
+    void notifyState();
+    /// GC要求
+    void requestGC();
+    /// GC要求待ち合わせ
+    void waitGC(msec_t);
+
+    /**********************************************************************//**
+    *   関数名 : リング使用数取得(getRingUsed)
+    *   引数   : なし
+    *   戻り値 : 未回収のTr数(trid_next - trid_collecting)
+    **//*********************************************************************/
+    inline size_t getRingUsed() const {
+        return static_cast<size_t>(trid_next.load() - trid_collecting.load());
+    }
+
+    /**********************************************************************//**
+    *   関数名 : リング使用率取得(getRingPercent)
+    *   引数   : なし
+    *   戻り値 : 未回収のTr数のMaxLineに対する割合(%)
+    **//*********************************************************************/
+    inline uint32_t getRingPercent() const {
+        return static_cast<uint32_t>(getRingUsed() * 100 / getMaxLine());
+    }
+
+    /**********************************************************************//**
+    *   関数名 : 自動GC要求判定(isGCRequested)
+    *   引数   : なし
+    *   戻り値 : true : GC要求中
+    **//*********************************************************************/
+    inline bool isGCRequested() const { return gc_pending.load() != 0; }
+
+    /**********************************************************************//**
+    *   関数名 : 常駐GC有無判定(hasGCWorker)
+    *   引数   : なし
+    *   戻り値 : true : 常駐GCあり
+    **//*********************************************************************/
+    inline bool hasGCWorker() const { return gc_workers.load() != 0; }
     /// トランザクションコミット
     void commitTr(trid_t);
     /// トランザクションアボート
     void abortTr(trid_t);
+    /// 終了したプロセスのTRCC公開
+    bool recoverTicket(trcc_t);
     /// トランザクション可視判定
-    static bool is_tr_valid_to_read(trid_t, trid_t);
+    static bool is_tr_valid_to_read(trid_t, trid_t, Status* = nullptr,
+            trcc_t* = nullptr);
+    /// コミット済みトランザクション可視判定(ヒントビット用)
+    static bool is_trcc_visible(trid_t, trid_t, uint32_t);
     /// トランザクション対象ID
     typedef enum {IS_XMAX, IS_LOCK} target_trid_t;
     /// xmaxとlockのトランザクション判定
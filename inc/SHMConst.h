@@ -30,6 +30,20 @@ static const int EXECUTE_FULL    = -3; ///< リソースビジー(メモリ不
 static const int EXECUTE_NULL    = -4; ///< フェッチの値がNULL
 static const int EXECUTE_TIMEOUT = -5; ///< タイムアウト
 
+/// インデックス種別
+enum IndexType {
+    INDEX_TREAP = 0,    ///< トリープ(二分木)
+    INDEX_BTREE = 1,    ///< B+木
+    INDEX_HASH  = 2     ///< ハッシュ(一致検索用)
+};
+
+/// 物理配置種別
+enum LayoutType {
+    LAYOUT_SPLIT       = 0, ///< 管理配列と要素本体を分離(要素本体は詰める)
+    LAYOUT_ALIGNED     = 1, ///< 分離し、要素本体をキャッシュライン単位に揃える
+    LAYOUT_INTERLEAVED = 2  ///< 管理情報と要素本体を隣接(一点参照向け)
+};
+
 }  // namespace SharedMemory
 
 #endif  // _SHMCONST_H_